@@ -0,0 +1,308 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "c-lib/dynlist.h"
+#include "c-lib/jobs.h"
+#include "c-lib/misc.h"
+#include "c-lib/profile.h"
+#include "c-lib/time.h"
+#include "font.h"
+#include "render.h"
+#include "state.h"
+
+#define BENCH_STEP_NS (1000000000ull / 60) // simulated clock, one 60hz frame
+#define BENCH_SPACING 2.5f              // between stress objects on the grid
+#define BENCH_ORBIT_PERIOD 12.0f        // seconds per camera revolution
+#define BENCH_TEXT_SIZE 12.0f
+
+typedef enum {
+  BENCH_PHASE_UPDATE, // simulation steps, then render_update: transforms,
+                      // culling, frame uniforms
+  BENCH_PHASE_WAIT,   // render_begin, blocked while the render thread and
+                      // the gpu still hold every packet
+  BENCH_PHASE_SUBMIT, // every render_submit
+  BENCH_PHASE_FLUSH,  // render_flush: sort, instancing, draw recording
+  BENCH_PHASE_TEXT,   // font layouts and sprite pushes
+  BENCH_PHASE_END,    // handing the packet to the render thread
+
+  BENCH_PHASE_COUNT,
+} bench_phase_t;
+
+static const char* const phase_names[BENCH_PHASE_COUNT] = {
+    [BENCH_PHASE_UPDATE] = "update", [BENCH_PHASE_WAIT] = "wait",
+    [BENCH_PHASE_SUBMIT] = "submit", [BENCH_PHASE_FLUSH] = "flush",
+    [BENCH_PHASE_TEXT] = "text",     [BENCH_PHASE_END] = "end",
+};
+
+typedef struct {
+  f64 min, mean, p50, p95, p99;
+} bench_summary_t; // in ms
+
+static struct {
+  DYNLIST(handle_t) objects;
+  DYNLIST(char*) lines;
+  DYNLIST(f64) frame_ms;
+  DYNLIST(f64) phase_ms[BENCH_PHASE_COUNT];
+  f32 extent; // half width of the stress grid
+} bench;
+
+// copies of a built in object laid out on a grid centered on the origin
+static void add_grid(handle_t source, u32 count, f32 y) {
+  if (count == 0) return;
+  // handles, not the pointer, since creating objects may move the pool
+  const handle_t mesh = get_render_object(source)->mesh;
+  const handle_t material = get_render_object(source)->material;
+
+  const u32 side = (u32)ceilf(sqrtf((f32)count));
+  const f32 offset = (side - 1) * BENCH_SPACING * 0.5f;
+  for (u32 i = 0; i < count; ++i) {
+    handle_t handle = render_object_create(mesh, material);
+    render_object_t* object = get_render_object(handle);
+    object->transform.position[0] = (i % side) * BENCH_SPACING - offset;
+    object->transform.position[1] = y;
+    object->transform.position[2] = (i / side) * BENCH_SPACING - offset;
+    *dynlist_push(bench.objects) = handle;
+  }
+  bench.extent = max(bench.extent, offset);
+}
+
+static void build_scene(const bench_options_t* options) {
+  bench.objects = dynlist_create(handle_t, options->cubes + options->spheres);
+  bench.lines = dynlist_create(char*, options->text_lines);
+  bench.frame_ms = dynlist_create(f64, options->frames);
+  for (u32 i = 0; i < BENCH_PHASE_COUNT; ++i) {
+    bench.phase_ms[i] = dynlist_create(f64, options->frames);
+  }
+
+  add_grid(get_scene()->cube, options->cubes, -2.0f);
+  add_grid(get_scene()->sphere, options->spheres, 1.0f);
+
+  for (u32 i = 0; i < options->text_lines; ++i) {
+    char line[64];
+    snprintf(line, sizeof(line), "%04u the quick brown fox jumps over", i);
+    *dynlist_push(bench.lines) = strdup(line);
+  }
+}
+
+static void destroy_scene(void) {
+  dynlist_each(bench.objects, handle) { render_object_destroy(*handle); }
+  dynlist_each(bench.lines, line) { free(*line); }
+  dynlist_destroy(bench.objects);
+  dynlist_destroy(bench.lines);
+  dynlist_destroy(bench.frame_ms);
+  for (u32 i = 0; i < BENCH_PHASE_COUNT; ++i) {
+    dynlist_destroy(bench.phase_ms[i]);
+  }
+}
+
+// orbits inside the grid looking at the center, so most of a large scene is
+// behind the camera or off to the side at any point on the path
+static void script_camera(f32 seconds) {
+  f32 angle = seconds * (2.0f * M_PI / BENCH_ORBIT_PERIOD);
+  f32 radius = bench.extent * 0.5f + 6.0f;
+  vec3 position = {cosf(angle) * radius,
+                   2.0f + sinf(angle * 2.0f) + bench.extent * 0.1f,
+                   sinf(angle) * radius};
+
+  vec3 to_center;
+  vec3_scale(to_center, position, -1.0f);
+  vec3_normalize(to_center, to_center);
+  f32 yaw = atan2f(to_center[2], to_center[0]) * (180.0f / M_PI);
+  f32 pitch = asinf(to_center[1]) * (180.0f / M_PI);
+  set_camera(position, yaw, pitch);
+}
+
+// ns since the last lap, in ms
+static f64 lap(u64* last) {
+  u64 now = time_ns();
+  f64 ms = (now - *last) / 1000000.0;
+  *last = now;
+  return ms;
+}
+
+static void render_frame(const bench_options_t* options, bool last,
+                         f64 phases[BENCH_PHASE_COUNT]) {
+  u64 t = time_ns();
+  time_update();
+  while (time_sim_step()) {
+    render_step(state.time.sim_time);
+    script_camera(state.time.sim_time);
+  }
+  render_update(state.time.alpha);
+  phases[BENCH_PHASE_UPDATE] = lap(&t);
+
+  render_begin();
+  phases[BENCH_PHASE_WAIT] = lap(&t);
+
+  render_cube();
+  render_ramp();
+  render_light();
+  render_sphere();
+  render_quad();
+  dynlist_each(bench.objects, handle) { render_submit(*handle); }
+  phases[BENCH_PHASE_SUBMIT] = lap(&t);
+
+  render_flush();
+  phases[BENCH_PHASE_FLUSH] = lap(&t);
+
+  for (u32 i = 0; i < options->text_lines; ++i) {
+    vec2 position = {10.0f, 10.0f + i * (BENCH_TEXT_SIZE + 2.0f)};
+    font_render_str(bench.lines[i], position,
+                    (vec2){BENCH_TEXT_SIZE, BENCH_TEXT_SIZE}, WHITE);
+  }
+  phases[BENCH_PHASE_TEXT] = lap(&t);
+
+  if (last && options->dump_path) render_dump(options->dump_path);
+  render_end();
+  phases[BENCH_PHASE_END] = lap(&t);
+}
+
+static int cmp_f64(const void* a, const void* b) {
+  f64 x = *(const f64*)a, y = *(const f64*)b;
+  return (x > y) - (x < y);
+}
+
+// nearest rank percentiles over a sorted copy
+static bench_summary_t summarize(const f64* samples, u32 n) {
+  if (n == 0) return (bench_summary_t){0};
+  f64* sorted = malloc(n * sizeof(f64));
+  ASSERT(sorted);
+  memcpy(sorted, samples, n * sizeof(f64));
+  qsort(sorted, n, sizeof(f64), cmp_f64);
+
+  f64 sum = 0.0;
+  for (u32 i = 0; i < n; ++i) sum += sorted[i];
+
+#define RANK(_p) sorted[(u32)ceil((_p) / 100.0 * n) - 1]
+  bench_summary_t summary = {
+      .min = sorted[0],
+      .mean = sum / n,
+      .p50 = RANK(50.0),
+      .p95 = RANK(95.0),
+      .p99 = RANK(99.0),
+  };
+#undef RANK
+  free(sorted);
+  return summary;
+}
+
+static void write_summary(FILE* fp, const char* name, const f64* samples,
+                          const char* trailer) {
+  bench_summary_t s = summarize(samples, dynlist_size(samples));
+  fprintf(fp,
+          "\"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, "
+          "\"p95\": %.4f, \"p99\": %.4f}%s\n",
+          name, s.min, s.mean, s.p50, s.p95, s.p99, trailer);
+}
+
+static bool write_report(const bench_options_t* options,
+                         const render_stats_t* last) {
+  FILE* fp = fopen(options->out_path, "w");
+  if (!fp) {
+    ERROR("cannot write bench report: %s", options->out_path);
+    return false;
+  }
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"frames\": %u,\n  \"warmup\": %u,\n  \"step_ms\": %.4f,\n",
+          options->frames, options->warmup, BENCH_STEP_NS / 1000000.0);
+  fprintf(fp, "  \"jobs\": %u,\n", jobs_worker_count());
+  fprintf(fp,
+          "  \"scene\": {\"objects\": %u, \"cubes\": %u, \"spheres\": %u, "
+          "\"text_lines\": %u},\n",
+          (u32)dynlist_size(bench.objects), options->cubes, options->spheres,
+          options->text_lines);
+  fprintf(fp, "  ");
+  write_summary(fp, "frame_ms", bench.frame_ms, ",");
+  fprintf(fp, "  \"phases_ms\": {\n");
+  for (u32 i = 0; i < BENCH_PHASE_COUNT; ++i) {
+    fprintf(fp, "    ");
+    write_summary(fp, phase_names[i], bench.phase_ms[i],
+                  i + 1 < BENCH_PHASE_COUNT ? "," : "");
+  }
+  fprintf(fp, "  },\n");
+
+  // smoothed, the gpu side is a few frames behind by design
+  const pass_timings_t* passes = get_pass_timings();
+  fprintf(fp, "  \"passes_ms\": {\n");
+  for (u32 i = 0; i < PASS_TIMER_COUNT; ++i) {
+    fprintf(fp, "    \"%s\": {\"cpu\": %.4f, \"gpu\": %.4f}%s\n",
+            pass_timer_name(i), passes->cpu_ms[i], passes->gpu_ms[i],
+            i + 1 < PASS_TIMER_COUNT ? "," : "");
+  }
+  fprintf(fp, "  },\n");
+
+  // overshoot past each deadline and distance of frame lengths from the
+  // period, both empty unless the config sets a frame_rate
+  const time_pacer_t* pacer = &state.time.pacer;
+  fprintf(fp, "  \"pacing_us\": {\"target_fps\": %u, \"missed\": %u",
+          pacer->target_rate, pacer->missed);
+  const struct {
+    const char* name;
+    const time_histogram_t* histogram;
+  } histograms[] = {{"overshoot", &pacer->overshoot},
+                    {"jitter", &pacer->jitter}};
+  for (u32 i = 0; i < ARRLEN(histograms); ++i) {
+    const time_histogram_t* h = histograms[i].histogram;
+    fprintf(fp,
+            ",\n    \"%s\": {\"p50\": %.0f, \"p95\": %.0f, \"p99\": %.0f, "
+            "\"max\": %.3f, \"bin_us\": %.0f, \"bins\": [",
+            histograms[i].name, time_histogram_percentile(h, 50.0),
+            time_histogram_percentile(h, 95.0),
+            time_histogram_percentile(h, 99.0), h->max_ns / 1000.0,
+            TIME_HISTOGRAM_BIN_NS / 1000.0);
+    for (u32 b = 0; b < TIME_HISTOGRAM_BINS; ++b) {
+      fprintf(fp, "%s%u", b ? ", " : "", h->bins[b]);
+    }
+    fprintf(fp, "]}");
+  }
+  fprintf(fp, "\n  },\n");
+  // the gl calls are counted on the render thread, so like the passes they
+  // are from a frame a few packets back
+  const gl_state_stats_t* gl_stats = get_gl_stats();
+  fprintf(fp,
+          "  \"last_frame\": {\"draw_calls\": %u, "
+          "\"instanced_draw_calls\": %u, \"instances\": %u, "
+          "\"sprites\": %u, \"visible\": %u, \"culled\": %u, "
+          "\"gl_calls_issued\": %u, \"gl_calls_skipped\": %u}\n",
+          last->draw_calls, last->instanced_draw_calls, last->instances,
+          last->sprites, last->visible, last->culled, gl_stats->issued,
+          gl_stats->skipped);
+  fprintf(fp, "}\n");
+  fclose(fp);
+  return true;
+}
+
+bool bench_run(const bench_options_t* options) {
+  build_scene(options);
+  time_set_fixed_step(BENCH_STEP_NS);
+  LOG("Bench: %u objects, %u text lines, %u frames after %u warmup",
+      (u32)dynlist_size(bench.objects), options->text_lines, options->frames,
+      options->warmup);
+
+  for (u32 frame = 0; frame < options->warmup + options->frames; ++frame) {
+    if (frame == options->warmup) time_reset_pacing_stats();
+    f64 phases[BENCH_PHASE_COUNT];
+    render_frame(options, frame + 1 == options->warmup + options->frames,
+                 phases);
+    time_update_late(); // only paces with a target rate in the config
+    PROFILE_FRAME();
+    if (frame < options->warmup) continue;
+
+    f64 total = 0.0;
+    for (u32 i = 0; i < BENCH_PHASE_COUNT; ++i) {
+      *dynlist_push(bench.phase_ms[i]) = phases[i];
+      total += phases[i];
+    }
+    *dynlist_push(bench.frame_ms) = total;
+  }
+
+  bench_summary_t frame = summarize(bench.frame_ms, options->frames);
+  LOG("Bench: frame ms min %.3f mean %.3f p50 %.3f p95 %.3f p99 %.3f",
+      frame.min, frame.mean, frame.p50, frame.p95, frame.p99);
+  bool ok = write_report(options, get_render_stats());
+  destroy_scene();
+  return ok;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+typedef struct {
+  u32 frames; // measured, after the warmup
+  u32 warmup;
+  u32 cubes, spheres, text_lines; // stress scene, added to the built in one
+  const char* out_path;           // json report
+  const char* dump_path;          // ppm of the last frame, or NULL
+} bench_options_t;
+
+// runs a fixed number of frames on a fixed clock with a scripted camera,
+// after render_init and config_init. returns false if the report failed
+bool bench_run(const bench_options_t* options);
@@ -0,0 +1,333 @@
+#ifndef _LIB_JOBS_H
+#define _LIB_JOBS_H
+
+// work stealing job system. each worker owns a chase-lev deque, pushing and
+// popping its own jobs at the bottom while idle workers steal from the top.
+// the thread that calls jobs_init is worker 0 and runs jobs while it waits,
+// so with a single worker everything runs on that thread
+//
+// exactly one translation unit defines CLIB_JOBS_IMPL before including this
+// header
+//
+//   static void square(u32 begin, u32 end, void* data) {
+//     f32* values = data;
+//     for (u32 i = begin; i < end; ++i) values[i] *= values[i];
+//   }
+//   parallel_for(count, 1024, square, values);
+//
+// dependencies are counters: a job run with a counter holds it up until the
+// job is done, and jobs_wait runs other jobs until the counter drains. a job
+// may itself run more jobs and wait on them
+
+#include <stdatomic.h>
+
+#include "types.h"
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_QUEUE_SIZE 4096 // per worker, pushing to a full one runs inline
+#define JOBS_MAX_RANGES 256  // per parallel_for
+
+typedef struct {
+  _Atomic u32 pending; // zero initialized, jobs still to finish
+} job_counter_t;
+
+typedef void (*job_fn_t)(void* data);
+typedef void (*job_range_fn_t)(u32 begin, u32 end, void* data);
+
+// workers including the calling thread, 0 for one per core
+void jobs_init(u32 workers);
+// every job must have been waited for
+void jobs_destroy(void);
+u32 jobs_worker_count(void);
+
+// only on workers, the thread that called jobs_init included. counter may be
+// NULL for a job nobody waits on
+void jobs_run(job_fn_t fn, void* data, job_counter_t* counter);
+void jobs_wait(job_counter_t* counter);
+
+// calls fn over [0, count) split into ranges of at least grain indices, and
+// returns once every range is done
+void parallel_for(u32 count, u32 grain, job_range_fn_t fn, void* data);
+
+#ifdef CLIB_JOBS_IMPL
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "math.h"
+#include "misc.h"
+#include "profile.h"
+
+#define JOBS_QUEUE_MASK (JOBS_QUEUE_SIZE - 1)
+#define JOBS_SPIN 64 // failed searches before an idle worker sleeps
+
+typedef struct {
+  job_fn_t fn;
+  void* data;
+  job_counter_t* counter;
+} jobs_job_t;
+
+// a thief reads its slot before the cas that claims it, while the owner may
+// already be reusing the slot. the read is thrown away when the cas fails,
+// but it still has to be atomic
+typedef struct {
+  _Atomic(job_fn_t) fn;
+  _Atomic(void*) data;
+  _Atomic(job_counter_t*) counter;
+} jobs_slot_t;
+
+typedef struct {
+  _Alignas(64) _Atomic i64 top; // stolen from here
+  _Alignas(64) _Atomic i64 bottom; // the owner pushes and pops here
+  _Alignas(64) jobs_slot_t slots[JOBS_QUEUE_SIZE];
+} jobs_queue_t;
+
+typedef struct {
+  job_range_fn_t fn;
+  void* data;
+  u32 begin, end;
+} jobs_range_t;
+
+static struct {
+  jobs_queue_t* queues;
+  pthread_t threads[JOBS_MAX_WORKERS];
+  u32 worker_count;
+  // idle workers sleep until signal changes, pushes only take the lock if
+  // someone is asleep
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  _Atomic u32 signal;
+  _Atomic u32 sleeping;
+  _Atomic bool quit;
+} jobs;
+
+static _Thread_local i32 jobs_local = -1; // worker index of the thread
+static _Thread_local u32 jobs_seed;
+
+static bool jobs_push(jobs_queue_t* queue, const jobs_job_t* job) {
+  const i64 b = atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+  const i64 t = atomic_load_explicit(&queue->top, memory_order_acquire);
+  if (b - t >= JOBS_QUEUE_SIZE) return false;
+
+  jobs_slot_t* slot = &queue->slots[b & JOBS_QUEUE_MASK];
+  atomic_store_explicit(&slot->fn, job->fn, memory_order_relaxed);
+  atomic_store_explicit(&slot->data, job->data, memory_order_relaxed);
+  atomic_store_explicit(&slot->counter, job->counter, memory_order_relaxed);
+  atomic_store_explicit(&queue->bottom, b + 1, memory_order_release);
+  return true;
+}
+
+static void jobs_read_slot(const jobs_slot_t* slot, jobs_job_t* job) {
+  job->fn = atomic_load_explicit(&slot->fn, memory_order_relaxed);
+  job->data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+  job->counter = atomic_load_explicit(&slot->counter, memory_order_relaxed);
+}
+
+// owner only, newest first so the data it just wrote is still in cache
+static bool jobs_take(jobs_queue_t* queue, jobs_job_t* job) {
+  const i64 b = atomic_load_explicit(&queue->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&queue->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  i64 t = atomic_load_explicit(&queue->top, memory_order_relaxed);
+  if (t > b) {
+    atomic_store_explicit(&queue->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+
+  jobs_read_slot(&queue->slots[b & JOBS_QUEUE_MASK], job);
+  if (t < b) return true;
+
+  // the last job, which a thief may be claiming at the same time
+  const bool won = atomic_compare_exchange_strong_explicit(
+      &queue->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+  atomic_store_explicit(&queue->bottom, b + 1, memory_order_relaxed);
+  return won;
+}
+
+// any thread, oldest first
+static bool jobs_steal(jobs_queue_t* queue, jobs_job_t* job) {
+  i64 t = atomic_load_explicit(&queue->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  const i64 b = atomic_load_explicit(&queue->bottom, memory_order_acquire);
+  if (t >= b) return false;
+
+  jobs_read_slot(&queue->slots[t & JOBS_QUEUE_MASK], job);
+  return atomic_compare_exchange_strong_explicit(
+      &queue->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+static void jobs_execute(const jobs_job_t* job) {
+  job->fn(job->data);
+  if (job->counter) {
+    atomic_fetch_sub_explicit(&job->counter->pending, 1,
+                              memory_order_acq_rel);
+  }
+}
+
+// xorshift, only spreads thieves over their victims
+static u32 jobs_random(void) {
+  jobs_seed ^= jobs_seed << 13;
+  jobs_seed ^= jobs_seed >> 17;
+  jobs_seed ^= jobs_seed << 5;
+  return jobs_seed;
+}
+
+static bool jobs_find(jobs_job_t* job) {
+  const u32 self = (u32)jobs_local;
+  if (jobs_take(&jobs.queues[self], job)) return true;
+
+  const u32 n = jobs.worker_count, start = jobs_random() % n;
+  for (u32 i = 0; i < n; ++i) {
+    const u32 victim = (start + i) % n;
+    if (victim != self && jobs_steal(&jobs.queues[victim], job)) return true;
+  }
+  return false;
+}
+
+static void jobs_wake(void) {
+  atomic_fetch_add(&jobs.signal, 1);
+  if (atomic_load(&jobs.sleeping) == 0) return;
+  pthread_mutex_lock(&jobs.lock);
+  pthread_cond_broadcast(&jobs.wake);
+  pthread_mutex_unlock(&jobs.lock);
+}
+
+// returns once signal moved on from what it was before the failed search,
+// so a push in between is never slept through
+static void jobs_sleep(u32 signal) {
+  pthread_mutex_lock(&jobs.lock);
+  atomic_fetch_add(&jobs.sleeping, 1);
+  while (atomic_load(&jobs.signal) == signal && !atomic_load(&jobs.quit)) {
+    pthread_cond_wait(&jobs.wake, &jobs.lock);
+  }
+  atomic_fetch_sub(&jobs.sleeping, 1);
+  pthread_mutex_unlock(&jobs.lock);
+}
+
+static void* jobs_worker_main(void* arg) {
+  jobs_local = (i32)(uintptr_t)arg;
+  jobs_seed = (u32)jobs_local * 2654435761u + 1;
+  PROFILE_THREAD_NAME("worker");
+
+  u32 idle = 0;
+  jobs_job_t job;
+  while (!atomic_load(&jobs.quit)) {
+    const u32 signal = atomic_load(&jobs.signal);
+    if (jobs_find(&job)) {
+      jobs_execute(&job);
+      idle = 0;
+    } else if (++idle < JOBS_SPIN) {
+      sched_yield();
+    } else {
+      jobs_sleep(signal);
+      idle = 0;
+    }
+  }
+  return NULL;
+}
+
+void jobs_init(u32 workers) {
+  if (workers == 0) workers = (u32)max(sysconf(_SC_NPROCESSORS_ONLN), 1);
+  workers = min(workers, JOBS_MAX_WORKERS);
+
+  jobs.worker_count = workers;
+  jobs.queues = aligned_alloc(_Alignof(jobs_queue_t),
+                              workers * sizeof(jobs_queue_t));
+  ASSERT(jobs.queues);
+  for (u32 i = 0; i < workers; ++i) {
+    atomic_init(&jobs.queues[i].top, 0);
+    atomic_init(&jobs.queues[i].bottom, 0);
+  }
+  atomic_init(&jobs.signal, 0);
+  atomic_init(&jobs.sleeping, 0);
+  atomic_init(&jobs.quit, false);
+  pthread_mutex_init(&jobs.lock, NULL);
+  pthread_cond_init(&jobs.wake, NULL);
+
+  jobs_local = 0;
+  jobs_seed = 1;
+  for (u32 i = 1; i < workers; ++i) {
+    if (pthread_create(&jobs.threads[i], NULL, jobs_worker_main,
+                       (void*)(uintptr_t)i) != 0) {
+      ERROR_EXIT("failed to create job worker %u\n", i);
+    }
+  }
+  LOG("Job system initialized with %u workers", workers);
+}
+
+void jobs_destroy(void) {
+  pthread_mutex_lock(&jobs.lock);
+  atomic_store(&jobs.quit, true);
+  pthread_cond_broadcast(&jobs.wake);
+  pthread_mutex_unlock(&jobs.lock);
+  for (u32 i = 1; i < jobs.worker_count; ++i) {
+    pthread_join(jobs.threads[i], NULL);
+  }
+
+  pthread_cond_destroy(&jobs.wake);
+  pthread_mutex_destroy(&jobs.lock);
+  free(jobs.queues);
+  jobs.queues = NULL;
+  jobs.worker_count = 0;
+  jobs_local = -1;
+}
+
+u32 jobs_worker_count(void) { return jobs.worker_count; }
+
+static void jobs_enqueue(job_fn_t fn, void* data, job_counter_t* counter) {
+  ASSERT(jobs_local >= 0, "jobs are only run from worker threads");
+  if (counter) {
+    atomic_fetch_add_explicit(&counter->pending, 1, memory_order_relaxed);
+  }
+  const jobs_job_t job = {fn, data, counter};
+  if (!jobs_push(&jobs.queues[jobs_local], &job)) jobs_execute(&job);
+}
+
+void jobs_run(job_fn_t fn, void* data, job_counter_t* counter) {
+  jobs_enqueue(fn, data, counter);
+  jobs_wake();
+}
+
+void jobs_wait(job_counter_t* counter) {
+  jobs_job_t job;
+  while (atomic_load_explicit(&counter->pending, memory_order_acquire)) {
+    if (jobs_find(&job)) {
+      jobs_execute(&job);
+    } else {
+      sched_yield(); // the rest are running on other workers
+    }
+  }
+}
+
+static void jobs_run_range(void* data) {
+  const jobs_range_t* range = data;
+  range->fn(range->begin, range->end, range->data);
+}
+
+void parallel_for(u32 count, u32 grain, job_range_fn_t fn, void* data) {
+  // a few ranges per worker, so one that starts late is evened out by the rest
+  const u32 by_grain = (count + max(grain, 1) - 1) / max(grain, 1);
+  const u32 ranges =
+      min(min(by_grain, jobs.worker_count * 4), (u32)JOBS_MAX_RANGES);
+  if (ranges <= 1) {
+    if (count) fn(0, count, data);
+    return;
+  }
+
+  jobs_range_t range[JOBS_MAX_RANGES];
+  job_counter_t counter = {0};
+  for (u32 i = 0; i < ranges; ++i) {
+    range[i] = (jobs_range_t){
+        .fn = fn,
+        .data = data,
+        .begin = (u32)((u64)count * i / ranges),
+        .end = (u32)((u64)count * (i + 1) / ranges),
+    };
+    jobs_enqueue(jobs_run_range, &range[i], &counter);
+  }
+  jobs_wake();
+  jobs_wait(&counter);
+}
+#endif
+#endif
@@ -8,8 +8,9 @@
 #include "macros.h"
 #include "time.h"
 
-M_INLINE void _log(const char* file, int line, const char* func,
-                   const char* prefix, const char* fmt, ...) {
+// not M_INLINE, gcc refuses to force inline a variadic function
+static inline M_UNUSED void _log(const char* file, int line, const char* func,
+                                 const char* prefix, const char* fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
   FILE* fp = !strcmp(prefix, "LOG") ? stdout : stderr;
@@ -20,7 +21,11 @@ M_INLINE void _log(const char* file, int line, const char* func,
 
   fprintf(fp, "[%s][%d.%03d][%s:%d][%s] ", prefix, secs, ms, file, line, func);
 
-  const int len = vsnprintf(NULL, 0, fmt, ap);
+  // the size pass consumes its own copy, a va_list can't be walked twice
+  va_list ap_size;
+  va_copy(ap_size, ap);
+  const int len = vsnprintf(NULL, 0, fmt, ap_size);
+  va_end(ap_size);
   char buf[len + 1];
   vsnprintf(buf, len + 1, fmt, ap);
   fprintf(fp, "%s%s", buf, buf[len] == '\n' ? "" : "\n");
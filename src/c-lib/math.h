@@ -6,6 +6,34 @@
 #include "macros.h"
 #include "types.h"
 
+// simd backend, picked at compile time from the target (-msse4.1, -mavx2,
+// -march=native), x86-64 always has sse2. CLIB_MATH_SCALAR keeps the scalar
+// versions, which also stay available as the _ref functions every simd
+// version is checked against. sse2 matches them exactly. the sse4.1 dot
+// products add in another order and the avx2 fused multiply adds skip the
+// product roundings, but a sum of n products rounded either way is within
+// n * 2^-24 * M of the exact sum, M the sum of the terms' magnitudes. the
+// two differ by under 2n ulp of M then, 8 for the 4 term products here
+#define MATH_SIMD_NONE 0
+#define MATH_SIMD_SSE2 1
+#define MATH_SIMD_SSE41 2
+#define MATH_SIMD_AVX2 3
+
+#if defined(CLIB_MATH_SCALAR)
+#define MATH_SIMD MATH_SIMD_NONE
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define MATH_SIMD MATH_SIMD_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define MATH_SIMD MATH_SIMD_SSE41
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MATH_SIMD MATH_SIMD_SSE2
+#else
+#define MATH_SIMD MATH_SIMD_NONE
+#endif
+
 #define min(_a, _b) ((_a) < (_b) ? (_a) : (_b))
 #define max(_a, _b) ((_a) > (_b) ? (_a) : (_b))
 #define clamp(_x, _mi, _ma) (max(_mi, min(_x, _ma)))
@@ -20,52 +48,141 @@
 #define float_eq(a, b) (fabsf((a) - (b)) < FLOAT_EPSILON)
 
 // vector and matrix utilities
-#define MATH_H_DEFINE_VEC(n) \
-typedef f32 vec##n[n]; \
-\
-M_INLINE void vec##n##_add(vec##n r, vec##n const a, vec##n const b) { \
+typedef f32 vec2[2];
+typedef f32 vec3[3];
+typedef f32 vec4[4];
+
+#define MATH_H_DEFINE_VEC(n, _sfx) \
+M_INLINE void vec##n##_add##_sfx(vec##n r, vec##n const a, vec##n const b) { \
     for (u32 i = 0; i < n; ++i) r[i] = a[i] + b[i]; \
 } \
 \
-M_INLINE void vec##n##_sub(vec##n r, vec##n const a, vec##n const b) { \
+M_INLINE void vec##n##_sub##_sfx(vec##n r, vec##n const a, vec##n const b) { \
     for (u32 i = 0; i < n; ++i) r[i] = a[i] - b[i]; \
 } \
 \
-M_INLINE void vec##n##_scale(vec##n r, vec##n const v, f32 const s) { \
+M_INLINE void vec##n##_scale##_sfx(vec##n r, vec##n const v, f32 const s) { \
     for (u32 i = 0; i < n; ++i) r[i] = v[i] * s; \
 } \
 \
-M_INLINE f32 vec##n##_dot(vec##n const a, vec##n const b) { \
+M_INLINE f32 vec##n##_dot##_sfx(vec##n const a, vec##n const b) { \
     f32 p = 0.0f; \
     for (u32 i = 0; i < n; ++i) p += b[i] * a[i]; \
     return p; \
 } \
 \
-M_INLINE f32 vec##n##_len(vec##n const v) { \
-    return sqrtf(vec##n##_dot(v, v)); \
+M_INLINE f32 vec##n##_len##_sfx(vec##n const v) { \
+    return sqrtf(vec##n##_dot##_sfx(v, v)); \
 } \
 \
-M_INLINE void vec##n##_normalize(vec##n r, vec##n const v) { \
-    f32 l = vec##n##_len(v); \
+M_INLINE void vec##n##_normalize##_sfx(vec##n r, vec##n const v) { \
+    f32 l = vec##n##_len##_sfx(v); \
     if (l > FLOAT_EPSILON) { \
         f32 k = 1.0f / l; \
-        vec##n##_scale(r, v, k); \
+        vec##n##_scale##_sfx(r, v, k); \
     } else { \
         for (u32 i = 0; i < n; ++i) r[i] = 0.0f; \
     } \
 } \
 \
-M_INLINE void vec##n##_mov(vec##n r, vec##n const src) { \
+M_INLINE void vec##n##_mov##_sfx(vec##n r, vec##n const src) { \
     for (u32 i = 0; i < n; ++i) r[i] = src[i]; \
 } \
 \
-M_INLINE void vec##n##_negate(vec##n r) { \
+M_INLINE void vec##n##_negate##_sfx(vec##n r) { \
     for (u32 i = 0; i < n; ++i) r[i] = -r[i]; \
+} \
+\
+M_INLINE void vec##n##_lerp##_sfx(vec##n r, vec##n const a, vec##n const b, \
+                            f32 const t) { \
+    for (u32 i = 0; i < n; ++i) r[i] = a[i] + (b[i] - a[i]) * t; \
 }
 
-MATH_H_DEFINE_VEC(2)
-MATH_H_DEFINE_VEC(3)
-MATH_H_DEFINE_VEC(4)
+MATH_H_DEFINE_VEC(2, )
+MATH_H_DEFINE_VEC(3, _ref)
+MATH_H_DEFINE_VEC(4, _ref)
+
+#if MATH_SIMD
+// x and y as one 64 bit load and z on its own, never reading past v[2].
+// through __m64, which may alias floats where a double load may not
+M_INLINE __m128 math_load3(const f32* v) {
+  __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)v);
+  return _mm_movelh_ps(xy, _mm_load_ss(v + 2));
+}
+
+M_INLINE void math_store3(f32* r, __m128 v) {
+  _mm_storel_pi((__m64*)r, v);
+  _mm_store_ss(r + 2, _mm_movehl_ps(v, v));
+}
+
+// dot products in lane 0. sse2 adds the lanes in the order of the scalar loop
+#if MATH_SIMD >= MATH_SIMD_SSE41
+M_INLINE __m128 math_dot3(__m128 a, __m128 b) { return _mm_dp_ps(a, b, 0x71); }
+M_INLINE __m128 math_dot4(__m128 a, __m128 b) { return _mm_dp_ps(a, b, 0xF1); }
+#else
+M_INLINE __m128 math_dot3(__m128 a, __m128 b) {
+  __m128 p = _mm_mul_ps(b, a);
+  __m128 s = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_add_ss(s, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+}
+
+M_INLINE __m128 math_dot4(__m128 a, __m128 b) {
+  __m128 p = _mm_mul_ps(b, a);
+  __m128 s = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+  s = _mm_add_ss(s, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+  return _mm_add_ss(s, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+#endif
+
+#define MATH_H_DEFINE_VEC_SIMD(n, _load, _store) \
+M_INLINE void vec##n##_add(vec##n r, vec##n const a, vec##n const b) { \
+    _store(r, _mm_add_ps(_load(a), _load(b))); \
+} \
+\
+M_INLINE void vec##n##_sub(vec##n r, vec##n const a, vec##n const b) { \
+    _store(r, _mm_sub_ps(_load(a), _load(b))); \
+} \
+\
+M_INLINE void vec##n##_scale(vec##n r, vec##n const v, f32 const s) { \
+    _store(r, _mm_mul_ps(_load(v), _mm_set1_ps(s))); \
+} \
+\
+M_INLINE f32 vec##n##_dot(vec##n const a, vec##n const b) { \
+    return _mm_cvtss_f32(math_dot##n(_load(a), _load(b))); \
+} \
+\
+M_INLINE f32 vec##n##_len(vec##n const v) { \
+    return sqrtf(vec##n##_dot(v, v)); \
+} \
+\
+M_INLINE void vec##n##_normalize(vec##n r, vec##n const v) { \
+    __m128 x = _load(v); \
+    f32 l = sqrtf(_mm_cvtss_f32(math_dot##n(x, x))); \
+    _store(r, l > FLOAT_EPSILON ? _mm_mul_ps(x, _mm_set1_ps(1.0f / l)) \
+                                : _mm_setzero_ps()); \
+} \
+\
+M_INLINE void vec##n##_mov(vec##n r, vec##n const src) { \
+    _store(r, _load(src)); \
+} \
+\
+M_INLINE void vec##n##_negate(vec##n r) { \
+    _store(r, _mm_xor_ps(_load(r), _mm_set1_ps(-0.0f))); \
+} \
+\
+M_INLINE void vec##n##_lerp(vec##n r, vec##n const a, vec##n const b, \
+                            f32 const t) { \
+    __m128 x = _load(a); \
+    _store(r, _mm_add_ps(x, _mm_mul_ps(_mm_sub_ps(_load(b), x), \
+                                       _mm_set1_ps(t)))); \
+}
+
+MATH_H_DEFINE_VEC_SIMD(3, math_load3, math_store3)
+MATH_H_DEFINE_VEC_SIMD(4, _mm_loadu_ps, _mm_storeu_ps)
+#else
+MATH_H_DEFINE_VEC(3, )
+MATH_H_DEFINE_VEC(4, )
+#endif
 
 M_INLINE void vec3_cross(vec3 r, vec3 const a, vec3 const b) {
   r[0] = a[1] * b[2] - a[2] * b[1];
@@ -80,9 +197,239 @@ M_INLINE void vec4_cross(vec4 r, vec4 const a, vec4 const b) {
   r[3] = 1.0f;
 }
 
-// Note: row-major format, thus, must use GL_TRUE in glUniformMatrix transpose
-// mat[row][column]
-// This is not the standard for OpenGL.
+/*
+   Fast approximations of libm's sinf, cosf, 1/sqrtf and atan2f, as 4 lane
+   simd kernels and as the _ref c versions doing the same arithmetic. The
+   scalar functions run one lane of the simd kernels where there is simd.
+   The bounds are against the exact result and hold for every backend,
+   --bench-math measures them again:
+
+   fast_sincos  |x| <= FAST_SINCOS_MAX   2 ulp, or 2^-23 absolute where the
+                                         result is under 2^-9 near a zero
+   fast_rsqrt   normal x > 0             4 ulp
+   fast_atan2   finite x and y           3 ulp, and 0 for (0, 0)
+
+   Outside of those the results are unspecified.
+*/
+#define FAST_SINCOS_MAX 8192.0f
+
+/*
+   x = j pi/2 + r with r in [-pi/4, pi/4]. pi/2 is split in three so the
+   first two products stay exact for any j in the domain, then sin and cos
+   of r come from the minimax polynomials of cephes' sinf and cosf, and the
+   quadrant j mod 4 picks which one is which and flips their signs:
+
+   j mod 4    0    1    2    3
+   sin x      s    c   -s   -c
+   cos x      c   -s   -c    s
+*/
+#define FAST_2_PI 0.636619772367581343f
+#define FAST_PI_2_A 1.5703125f
+#define FAST_PI_2_B 4.837512969970703125e-4f
+#define FAST_PI_2_C 7.54978995489188216e-8f
+#define FAST_SIN_P0 -1.9515295891e-4f
+#define FAST_SIN_P1 8.3321608736e-3f
+#define FAST_SIN_P2 -1.6666654611e-1f
+#define FAST_COS_P0 2.443315711809948e-5f
+#define FAST_COS_P1 -1.388731625493765e-3f
+#define FAST_COS_P2 4.166664568298827e-2f
+
+// nearest integer, ties to even like the simd conversion. lrintf is a libm
+// call unless errno is off
+M_INLINE i32 fast_roundf(f32 x) {
+#if MATH_SIMD
+  return _mm_cvtss_si32(_mm_set_ss(x));
+#else
+  return (i32)lrintf(x);
+#endif
+}
+
+M_INLINE void fast_sincosf_ref(f32 x, f32* s, f32* c) {
+  const i32 j = fast_roundf(x * FAST_2_PI);
+  const f32 fj = (f32)j;
+  f32 r = x - fj * FAST_PI_2_A;
+  r -= fj * FAST_PI_2_B;
+  r -= fj * FAST_PI_2_C;
+
+  const f32 z = r * r;
+  const f32 ps =
+      ((FAST_SIN_P0 * z + FAST_SIN_P1) * z + FAST_SIN_P2) * z * r + r;
+  const f32 pc =
+      ((FAST_COS_P0 * z + FAST_COS_P1) * z + FAST_COS_P2) * z * z - 0.5f * z +
+      1.0f;
+
+  const bool swap = j & 1;
+  const f32 sin_r = swap ? pc : ps, cos_r = swap ? ps : pc;
+  *s = j & 2 ? -sin_r : sin_r;
+  *c = (j + 1) & 2 ? -cos_r : cos_r;
+}
+
+/*
+   Cephes' atanf on [0, tan(pi/8)]. Between tan(pi/8) and 1 it takes
+   atan(a) = pi/4 + atan((a - 1) / (a + 1)), and with a = lo / hi of |y|
+   and |x| both cases are one divide. Octants past the first are mirrored
+   back with pi/2 - r, pi - r and the sign of y
+*/
+#define FAST_TAN_PI_8 0.414213562373095f
+#define FAST_ATAN_P0 8.05374449538e-2f
+#define FAST_ATAN_P1 -1.38776856032e-1f
+#define FAST_ATAN_P2 1.99777106478e-1f
+#define FAST_ATAN_P3 -3.33329491539e-1f
+
+M_INLINE f32 fast_atan2f_ref(f32 y, f32 x) {
+  const f32 ax = fabsf(x), ay = fabsf(y);
+  const f32 lo = min(ax, ay), hi = max(ax, ay);
+  const bool upper = lo > FAST_TAN_PI_8 * hi;
+  const f32 num = upper ? lo - hi : lo, den = upper ? lo + hi : hi;
+  const f32 a = den > 0.0f ? num / den : 0.0f;
+
+  const f32 z = a * a;
+  f32 r = (((FAST_ATAN_P0 * z + FAST_ATAN_P1) * z + FAST_ATAN_P2) * z +
+           FAST_ATAN_P3) * z * a + a;
+  if (upper) r += (f32)M_PI_4;
+  if (ay > ax) r = (f32)M_PI_2 - r;
+  if (x < 0.0f) r = (f32)M_PI - r;
+  return copysignf(r, y);
+}
+
+#if MATH_SIMD
+// j is rounded to nearest like fast_roundf, sse's default rounding mode
+M_INLINE void fast_sincos4(__m128 x, __m128* s, __m128* c) {
+  const __m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(FAST_2_PI)));
+  const __m128 fj = _mm_cvtepi32_ps(j);
+  __m128 r = _mm_sub_ps(x, _mm_mul_ps(fj, _mm_set1_ps(FAST_PI_2_A)));
+  r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(FAST_PI_2_B)));
+  r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(FAST_PI_2_C)));
+
+  const __m128 z = _mm_mul_ps(r, r);
+  __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(FAST_SIN_P0), z),
+                         _mm_set1_ps(FAST_SIN_P1));
+  ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(FAST_SIN_P2));
+  ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), r), r);
+  __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(FAST_COS_P0), z),
+                         _mm_set1_ps(FAST_COS_P1));
+  pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(FAST_COS_P2));
+  pc = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(pc, z), z),
+                  _mm_mul_ps(_mm_set1_ps(0.5f), z));
+  pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+  // bit 0 of j swaps the polynomials, bit 1 moved up to the sign bit
+  // flips them
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128 swap =
+      _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+  const __m128 sin_r = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+  const __m128 cos_r = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128 sin_sign = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_and_si128(j, two), 30));
+  const __m128 cos_sign = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one), two), 30));
+  *s = _mm_xor_ps(sin_r, sin_sign);
+  *c = _mm_xor_ps(cos_r, cos_sign);
+}
+
+// the hardware estimate is good to 12 bits, one newton step doubles that:
+// y' = y (1.5 - 0.5 x y^2)
+M_INLINE __m128 fast_rsqrt4(__m128 x) {
+  const __m128 y = _mm_rsqrt_ps(x);
+  const __m128 hxyy = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), x),
+                                 _mm_mul_ps(y, y));
+  return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), hxyy));
+}
+
+
+M_INLINE __m128 fast_atan2_4(__m128 y, __m128 x) {
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 ax = _mm_andnot_ps(sign, x), ay = _mm_andnot_ps(sign, y);
+  const __m128 lo = _mm_min_ps(ax, ay), hi = _mm_max_ps(ax, ay);
+  const __m128 upper =
+      _mm_cmpgt_ps(lo, _mm_mul_ps(_mm_set1_ps(FAST_TAN_PI_8), hi));
+  const __m128 num = _mm_sub_ps(lo, _mm_and_ps(upper, hi));
+  const __m128 den = _mm_or_ps(_mm_and_ps(upper, _mm_add_ps(lo, hi)),
+                               _mm_andnot_ps(upper, hi));
+  const __m128 a = _mm_and_ps(_mm_cmpgt_ps(den, _mm_setzero_ps()),
+                              _mm_div_ps(num, den));
+
+  const __m128 z = _mm_mul_ps(a, a);
+  __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(FAST_ATAN_P0), z),
+                        _mm_set1_ps(FAST_ATAN_P1));
+  r = _mm_add_ps(_mm_mul_ps(r, z), _mm_set1_ps(FAST_ATAN_P2));
+  r = _mm_add_ps(_mm_mul_ps(r, z), _mm_set1_ps(FAST_ATAN_P3));
+  r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, z), a), a);
+  r = _mm_add_ps(r, _mm_and_ps(upper, _mm_set1_ps((f32)M_PI_4)));
+
+  const __m128 steep = _mm_cmpgt_ps(ay, ax);
+  r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps((f32)M_PI_2), r)),
+                _mm_andnot_ps(steep, r));
+  const __m128 back = _mm_cmplt_ps(x, _mm_setzero_ps());
+  r = _mm_or_ps(_mm_and_ps(back, _mm_sub_ps(_mm_set1_ps((f32)M_PI), r)),
+                _mm_andnot_ps(back, r));
+  return _mm_or_ps(r, _mm_and_ps(sign, y));
+}
+
+// one lane of the above, which has no branches to mispredict on the
+// quadrant or octant
+M_INLINE void fast_sincosf(f32 x, f32* s, f32* c) {
+  __m128 s4, c4;
+  fast_sincos4(_mm_set_ss(x), &s4, &c4);
+  *s = _mm_cvtss_f32(s4);
+  *c = _mm_cvtss_f32(c4);
+}
+
+M_INLINE f32 fast_rsqrtf(f32 x) {
+  return _mm_cvtss_f32(fast_rsqrt4(_mm_set_ss(x)));
+}
+
+M_INLINE f32 fast_atan2f(f32 y, f32 x) {
+  return _mm_cvtss_f32(fast_atan2_4(_mm_set_ss(y), _mm_set_ss(x)));
+}
+#else
+M_INLINE void fast_sincosf(f32 x, f32* s, f32* c) {
+  fast_sincosf_ref(x, s, c);
+}
+
+M_INLINE f32 fast_atan2f(f32 y, f32 x) { return fast_atan2f_ref(y, x); }
+
+// no estimate instruction to refine, and a divide and sqrt beat the
+// integer trick with enough newton steps to match the simd error
+M_INLINE f32 fast_rsqrtf(f32 x) { return 1.0f / sqrtf(x); }
+#endif
+
+// sin and cos of n angles, 4 at a time where there is simd
+M_INLINE void fast_sincos_n(f32* s, f32* c, const f32* x, u32 n) {
+  u32 i = 0;
+#if MATH_SIMD
+  for (; i + 4 <= n; i += 4) {
+    __m128 s4, c4;
+    fast_sincos4(_mm_loadu_ps(x + i), &s4, &c4);
+    _mm_storeu_ps(s + i, s4);
+    _mm_storeu_ps(c + i, c4);
+  }
+#endif
+  for (; i < n; ++i) fast_sincosf(x[i], &s[i], &c[i]);
+}
+
+/*
+   mat4x4 is column major by default, mat[column][row], the layout OpenGL
+   expects, so a matrix is copied into uniforms and vertex buffers as is.
+   CLIB_MATH_ROW_MAJOR stores mat[row][column] instead, which then has to be
+   uploaded with MATH_GL_TRANSPOSE. Every mat4x4 function gives the same
+   matrix either way, and the same floats, since each element is summed in
+   the same order. M4 reads and writes an element by row and column in both.
+   A build that lets the compiler fuse multiply adds, -O2 with -mfma, fuses
+   each layout's code in different places and can round them differently.
+
+   The affine mat3x4 and mat3x3 below are always stored by rows.
+*/
+#ifdef CLIB_MATH_ROW_MAJOR
+#define MATH_COLUMN_MAJOR 0
+#define M4(_m, _r, _c) ((_m)[_r][_c])
+#else
+#define MATH_COLUMN_MAJOR 1
+#define M4(_m, _r, _c) ((_m)[_c][_r])
+#endif
+#define MATH_GL_TRANSPOSE (!MATH_COLUMN_MAJOR) // GL_TRUE or GL_FALSE
 
 typedef vec4 mat4x4[4];
 
@@ -98,19 +445,115 @@ M_INLINE void mat4x4_identity(mat4x4 M) {
   M[3][3] = 1.0f;
 }
 
-M_INLINE void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+M_INLINE void mat4x4_mul_ref(mat4x4 M, mat4x4 const a, mat4x4 const b) {
   mat4x4 temp;
   for (u32 r = 0; r < 4; ++r) {
     for (u32 c = 0; c < 4; ++c) {
-      temp[r][c] = 0.0f;
+      M4(temp, r, c) = 0.0f;
       for (u32 i = 0; i < 4; ++i) {
-        temp[r][c] += a[r][i] * b[i][c];
+        M4(temp, r, c) += M4(a, r, i) * M4(b, i, c);
       }
     }
   }
   mat4x4_mov(M, temp);
 }
 
+// r = M * v, with v as a column vector
+M_INLINE void mat4x4_mul_vec4_ref(vec4 r, mat4x4 const M, vec4 const v) {
+  vec4 temp;
+  for (u32 i = 0; i < 4; ++i) {
+    temp[i] = M4(M, i, 0) * v[0] + M4(M, i, 1) * v[1] + M4(M, i, 2) * v[2] +
+              M4(M, i, 3) * v[3];
+  }
+  memcpy(r, temp, sizeof(vec4));
+}
+
+#if MATH_SIMD >= MATH_SIMD_AVX2
+#ifdef __FMA__
+#define math_madd256(_a, _b, _c) _mm256_fmadd_ps((_a), (_b), (_c))
+#else
+#define math_madd256(_a, _b, _c) _mm256_add_ps(_mm256_mul_ps((_a), (_b)), (_c))
+#endif
+
+// the simd products multiply the stored rows, two of the result at a time,
+// each row of a splatted in its own half
+M_INLINE void math_mul_rows4(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+  const __m256 b0 = _mm256_broadcast_ps((const __m128*)b[0]);
+  const __m256 b1 = _mm256_broadcast_ps((const __m128*)b[1]);
+  const __m256 b2 = _mm256_broadcast_ps((const __m128*)b[2]);
+  const __m256 b3 = _mm256_broadcast_ps((const __m128*)b[3]);
+  __m256 rows[2];
+  for (u32 r = 0; r < 2; ++r) {
+    const __m256 x = _mm256_loadu_ps(a[r * 2]);
+    __m256 s = _mm256_mul_ps(_mm256_shuffle_ps(x, x, 0x00), b0);
+    s = math_madd256(_mm256_shuffle_ps(x, x, 0x55), b1, s);
+    s = math_madd256(_mm256_shuffle_ps(x, x, 0xAA), b2, s);
+    rows[r] = math_madd256(_mm256_shuffle_ps(x, x, 0xFF), b3, s);
+  }
+  // stored once both are done, M may be a or b
+  _mm256_storeu_ps(M[0], rows[0]);
+  _mm256_storeu_ps(M[2], rows[1]);
+}
+#elif MATH_SIMD
+// the simd products multiply the stored rows, each row of the result is the
+// rows of b weighted by a row of a
+M_INLINE void math_mul_rows4(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+  const __m128 b0 = _mm_loadu_ps(b[0]), b1 = _mm_loadu_ps(b[1]);
+  const __m128 b2 = _mm_loadu_ps(b[2]), b3 = _mm_loadu_ps(b[3]);
+  __m128 rows[4];
+  for (u32 r = 0; r < 4; ++r) {
+    __m128 s = _mm_mul_ps(_mm_set1_ps(a[r][0]), b0);
+    s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[r][1]), b1));
+    s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[r][2]), b2));
+    rows[r] = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[r][3]), b3));
+  }
+  for (u32 r = 0; r < 4; ++r) _mm_storeu_ps(M[r], rows[r]);
+}
+#endif
+
+#if MATH_SIMD
+// column major storage holds the transpose, and M^T = b^T a^T
+M_INLINE void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+#if MATH_COLUMN_MAJOR
+  math_mul_rows4(M, b, a);
+#else
+  math_mul_rows4(M, a, b);
+#endif
+}
+#else
+M_INLINE void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+  mat4x4_mul_ref(M, a, b);
+}
+#endif
+
+#if MATH_SIMD && MATH_COLUMN_MAJOR
+// the columns weighted by v, each lane sums one row in the same order as the
+// scalar version
+M_INLINE void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v) {
+  __m128 s = _mm_mul_ps(_mm_loadu_ps(M[0]), _mm_set1_ps(v[0]));
+  s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(M[1]), _mm_set1_ps(v[1])));
+  s = _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(M[2]), _mm_set1_ps(v[2])));
+  _mm_storeu_ps(r, _mm_add_ps(s, _mm_mul_ps(_mm_loadu_ps(M[3]),
+                                            _mm_set1_ps(v[3]))));
+}
+#elif MATH_SIMD
+// the row products are transposed, so each lane sums one row in the same
+// order as the scalar version
+M_INLINE void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v) {
+  const __m128 x = _mm_loadu_ps(v);
+  __m128 p0 = _mm_mul_ps(_mm_loadu_ps(M[0]), x);
+  __m128 p1 = _mm_mul_ps(_mm_loadu_ps(M[1]), x);
+  __m128 p2 = _mm_mul_ps(_mm_loadu_ps(M[2]), x);
+  __m128 p3 = _mm_mul_ps(_mm_loadu_ps(M[3]), x);
+  _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+  _mm_storeu_ps(r, _mm_add_ps(_mm_add_ps(_mm_add_ps(p0, p1), p2), p3));
+}
+#else
+M_INLINE void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v) {
+  mat4x4_mul_vec4_ref(r, M, v);
+}
+#endif
+
 M_INLINE void mat4x4_from_translation(mat4x4 T, f32 x, f32 y, f32 z) {
   /*
      1.0f, 0.0f, 0.0f, x, // x translation
@@ -119,9 +562,9 @@ M_INLINE void mat4x4_from_translation(mat4x4 T, f32 x, f32 y, f32 z) {
      0.0f, 0.0f, 0.0f, 1.0f,
   */
   mat4x4_identity(T);
-  T[0][3] = x;
-  T[1][3] = y;
-  T[2][3] = z;
+  M4(T, 0, 3) = x;
+  M4(T, 1, 3) = y;
+  M4(T, 2, 3) = z;
 }
 
 M_INLINE void mat4x4_translate(mat4x4 M, f32 x, f32 y, f32 z) {
@@ -158,12 +601,12 @@ M_INLINE void mat4x4_translate(mat4x4 M, f32 x, f32 y, f32 z) {
 M_INLINE void mat4x4_rotate_z(mat4x4 result, mat4x4 const M, f32 theta) {
   f32 s = sinf(theta);
   f32 c = cosf(theta);
-  mat4x4 R = {
-      {c, -s, 0.0f, 0.0f},
-      {s, c, 0.0f, 0.0f},
-      {0.0f, 0.0f, 1.0f, 0.0f},
-      {0.0f, 0.0f, 0.0f, 1.0f},
-  };
+  mat4x4 R;
+  mat4x4_identity(R);
+  M4(R, 0, 0) = c;
+  M4(R, 0, 1) = -s;
+  M4(R, 1, 0) = s;
+  M4(R, 1, 1) = c;
   mat4x4_mul(result, M, R);
 }
 
@@ -185,12 +628,12 @@ M_INLINE void mat4x4_rotate_z(mat4x4 result, mat4x4 const M, f32 theta) {
 M_INLINE void mat4x4_rotate_x(mat4x4 result, mat4x4 const M, f32 theta) {
   f32 s = sinf(theta);
   f32 c = cosf(theta);
-  mat4x4 R = {
-      {1.0f, 0.0f, 0.0f, 0.0f},
-      {0.0f, c, -s, 0.0f},
-      {0.0f, s, c, 0.0f},
-      {0.0f, 0.0f, 0.0f, 1.0f},
-  };
+  mat4x4 R;
+  mat4x4_identity(R);
+  M4(R, 1, 1) = c;
+  M4(R, 1, 2) = -s;
+  M4(R, 2, 1) = s;
+  M4(R, 2, 2) = c;
   mat4x4_mul(result, M, R);
 }
 
@@ -205,12 +648,12 @@ M_INLINE void mat4x4_rotate_x(mat4x4 result, mat4x4 const M, f32 theta) {
 M_INLINE void mat4x4_rotate_y(mat4x4 result, mat4x4 const M, f32 theta) {
   f32 s = sinf(theta);
   f32 c = cosf(theta);
-  mat4x4 R = {
-      {c, 0.0f, s, 0.0f},
-      {0.0f, 1.0f, 0.0f, 0.0f},
-      {-s, 0.0f, c, 0.0f},
-      {0.0f, 0.0f, 0.0f, 1.0f},
-  };
+  mat4x4 R;
+  mat4x4_identity(R);
+  M4(R, 0, 0) = c;
+  M4(R, 0, 2) = s;
+  M4(R, 2, 0) = -s;
+  M4(R, 2, 2) = c;
   mat4x4_mul(result, M, R);
 }
 
@@ -281,12 +724,12 @@ M_INLINE void mat4x4_perspective(mat4x4 M, f32 y_fov_radians, f32 aspect, f32 n,
   f32 b = (2.0f * f * n) / (n - f);
 
   mat4x4_identity(M);
-  M[0][0] = c;
-  M[1][1] = d;
-  M[2][2] = a;
-  M[2][3] = b;
-  M[3][2] = -1.0f;
-  M[3][3] = 0.0f;
+  M4(M, 0, 0) = c;
+  M4(M, 1, 1) = d;
+  M4(M, 2, 2) = a;
+  M4(M, 2, 3) = b;
+  M4(M, 3, 2) = -1.0f;
+  M4(M, 3, 3) = 0.0f;
 }
 
 M_INLINE void mat4x4_scale_aniso(mat4x4 result, mat4x4 const M, f32 sx, f32 sy,
@@ -301,12 +744,12 @@ M_INLINE void mat4x4_scale_aniso(mat4x4 result, mat4x4 const M, f32 sx, f32 sy,
 
 M_INLINE void mat4x4_ortho(mat4x4 M, f32 l, f32 r, f32 b, f32 t, f32 n, f32 f) {
   mat4x4_identity(M);
-  M[0][0] = 2.0f / (r - l);
-  M[1][1] = 2.0f / (t - b);
-  M[2][2] = -2.0f / (f - n);
-  M[0][3] = (r + l) / (l - r);
-  M[1][3] = (t + b) / (b - t);
-  M[2][3] = (f + n) / (n - f);
+  M4(M, 0, 0) = 2.0f / (r - l);
+  M4(M, 1, 1) = 2.0f / (t - b);
+  M4(M, 2, 2) = -2.0f / (f - n);
+  M4(M, 0, 3) = (r + l) / (l - r);
+  M4(M, 1, 3) = (t + b) / (b - t);
+  M4(M, 2, 3) = (f + n) / (n - f);
 }
 
 M_INLINE void mat4x4_look_at(mat4x4 M, vec3 const eye, vec3 const center,
@@ -324,27 +767,29 @@ M_INLINE void mat4x4_look_at(mat4x4 M, vec3 const eye, vec3 const center,
   // y-axis
   vec3_cross(t, s, f);
 
-  M[0][0] = s[0];
-  M[0][1] = s[1];
-  M[0][2] = s[2];
-  M[0][3] = -vec3_dot(s, eye);
-
-  M[1][0] = t[0];
-  M[1][1] = t[1];
-  M[1][2] = t[2];
-  M[1][3] = -vec3_dot(t, eye);
-
-  M[2][0] = -f[0];
-  M[2][1] = -f[1];
-  M[2][2] = -f[2];
-  M[2][3] = vec3_dot(f, eye);
-
-  M[3][0] = 0.0f;
-  M[3][1] = 0.0f;
-  M[3][2] = 0.0f;
-  M[3][3] = 1.0f;
+  M4(M, 0, 0) = s[0];
+  M4(M, 0, 1) = s[1];
+  M4(M, 0, 2) = s[2];
+  M4(M, 0, 3) = -vec3_dot(s, eye);
+
+  M4(M, 1, 0) = t[0];
+  M4(M, 1, 1) = t[1];
+  M4(M, 1, 2) = t[2];
+  M4(M, 1, 3) = -vec3_dot(t, eye);
+
+  M4(M, 2, 0) = -f[0];
+  M4(M, 2, 1) = -f[1];
+  M4(M, 2, 2) = -f[2];
+  M4(M, 2, 3) = vec3_dot(f, eye);
+
+  M4(M, 3, 0) = 0.0f;
+  M4(M, 3, 1) = 0.0f;
+  M4(M, 3, 2) = 0.0f;
+  M4(M, 3, 3) = 1.0f;
 }
 
+// transposing commutes with transposing the storage, so this works on
+// whichever layout is stored
 M_INLINE void mat4x4_transpose(mat4x4 M, mat4x4 const src) {
   mat4x4 res;
   for (u32 r = 0; r < 4; ++r) {
@@ -355,7 +800,15 @@ M_INLINE void mat4x4_transpose(mat4x4 M, mat4x4 const src) {
   mat4x4_mov(M, res);
 }
 
-M_INLINE bool mat4x4_invert(mat4x4 M, mat4x4 const src) {
+// both inverses are written for column major storage. a row major matrix
+// is transposed on the way in and out, so the two layouts round the same
+M_INLINE bool mat4x4_invert_ref(mat4x4 M, mat4x4 const m) {
+#if MATH_COLUMN_MAJOR
+  const vec4* src = m;
+#else
+  mat4x4 src;
+  mat4x4_transpose(src, m);
+#endif
   mat4x4 inv;
   f32 det;
 
@@ -453,8 +906,534 @@ M_INLINE bool mat4x4_invert(mat4x4 M, mat4x4 const src) {
     }
   }
 
+#if MATH_COLUMN_MAJOR
   mat4x4_mov(M, inv);
+#else
+  mat4x4_transpose(M, inv);
+#endif
+  return true;
+}
+
+#if MATH_SIMD
+#define math_swizzle(_v, _x, _y, _z, _w) \
+  _mm_shuffle_ps((_v), (_v), _MM_SHUFFLE(_w, _z, _y, _x))
+#define math_shuffle(_a, _b, _x, _y, _z, _w) \
+  _mm_shuffle_ps((_a), (_b), _MM_SHUFFLE(_w, _z, _y, _x))
+
+// 2x2 matrices packed a b c d as one register, rows first
+M_INLINE __m128 math_mat2_mul(__m128 a, __m128 b) {
+  return _mm_add_ps(_mm_mul_ps(a, math_swizzle(b, 0, 3, 0, 3)),
+                    _mm_mul_ps(math_swizzle(a, 1, 0, 3, 2),
+                               math_swizzle(b, 2, 1, 2, 1)));
+}
+
+// adj(a) * b
+M_INLINE __m128 math_mat2_adj_mul(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(math_swizzle(a, 3, 3, 0, 0), b),
+                    _mm_mul_ps(math_swizzle(a, 1, 1, 2, 2),
+                               math_swizzle(b, 2, 3, 0, 1)));
+}
+
+// a * adj(b)
+M_INLINE __m128 math_mat2_mul_adj(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(a, math_swizzle(b, 3, 0, 3, 0)),
+                    _mm_mul_ps(math_swizzle(a, 1, 0, 3, 2),
+                               math_swizzle(b, 2, 1, 2, 1)));
+}
+
+/*
+   Inverse through the four 2x2 blocks of src
+
+   | A B |
+   | C D |
+
+   whose adjugates give each block of the inverse from 2x2 products, with
+
+   det = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+
+   Rounds within a few ulp of the cofactor expansion in mat4x4_invert_ref
+*/
+M_INLINE bool mat4x4_invert(mat4x4 M, mat4x4 const src) {
+  __m128 r0 = _mm_loadu_ps(src[0]), r1 = _mm_loadu_ps(src[1]);
+  __m128 r2 = _mm_loadu_ps(src[2]), r3 = _mm_loadu_ps(src[3]);
+#if !MATH_COLUMN_MAJOR
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+#endif
+  const __m128 A = _mm_movelh_ps(r0, r1), B = _mm_movehl_ps(r1, r0);
+  const __m128 C = _mm_movelh_ps(r2, r3), D = _mm_movehl_ps(r3, r2);
+
+  // |A| |B| |C| |D|
+  const __m128 dets =
+      _mm_sub_ps(_mm_mul_ps(math_shuffle(r0, r2, 0, 2, 0, 2),
+                            math_shuffle(r1, r3, 1, 3, 1, 3)),
+                 _mm_mul_ps(math_shuffle(r0, r2, 1, 3, 1, 3),
+                            math_shuffle(r1, r3, 0, 2, 0, 2)));
+  const __m128 det_a = math_swizzle(dets, 0, 0, 0, 0);
+  const __m128 det_b = math_swizzle(dets, 1, 1, 1, 1);
+  const __m128 det_c = math_swizzle(dets, 2, 2, 2, 2);
+  const __m128 det_d = math_swizzle(dets, 3, 3, 3, 3);
+
+  // the adjugates of the blocks of the inverse, before dividing by det
+  const __m128 dc = math_mat2_adj_mul(D, C);
+  const __m128 ab = math_mat2_adj_mul(A, B);
+  __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), math_mat2_mul(B, dc));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), math_mat2_mul(C, ab));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), math_mat2_mul_adj(D, ab));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), math_mat2_mul_adj(A, dc));
+
+  __m128 tr = _mm_mul_ps(ab, math_swizzle(dc, 0, 2, 1, 3));
+  tr = _mm_add_ps(tr, math_swizzle(tr, 2, 3, 0, 1));
+  tr = _mm_add_ss(tr, math_swizzle(tr, 1, 0, 3, 2));
+  const f32 det = _mm_cvtss_f32(_mm_sub_ss(
+      _mm_add_ss(_mm_mul_ss(det_a, det_d), _mm_mul_ss(det_b, det_c)), tr));
+
+  // check if invertible
+  if (fabsf(det) < FLOAT_EPSILON) return false;
+
+  // the adjugate of each block flips the sign of its off diagonal
+  const __m128 scale = _mm_mul_ps(_mm_set1_ps(1.0f / det),
+                                  _mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f));
+  x = _mm_mul_ps(x, scale);
+  y = _mm_mul_ps(y, scale);
+  z = _mm_mul_ps(z, scale);
+  w = _mm_mul_ps(w, scale);
+
+  // and swaps its diagonal, done while putting the blocks back into rows
+  __m128 o0 = math_shuffle(x, y, 3, 1, 3, 1);
+  __m128 o1 = math_shuffle(x, y, 2, 0, 2, 0);
+  __m128 o2 = math_shuffle(z, w, 3, 1, 3, 1);
+  __m128 o3 = math_shuffle(z, w, 2, 0, 2, 0);
+#if !MATH_COLUMN_MAJOR
+  _MM_TRANSPOSE4_PS(o0, o1, o2, o3);
+#endif
+  _mm_storeu_ps(M[0], o0);
+  _mm_storeu_ps(M[1], o1);
+  _mm_storeu_ps(M[2], o2);
+  _mm_storeu_ps(M[3], o3);
   return true;
 }
+#else
+M_INLINE bool mat4x4_invert(mat4x4 M, mat4x4 const src) {
+  return mat4x4_invert_ref(M, src);
+}
+#endif
+
+/*
+   Affine transforms, the top three rows of a mat4x4 whose bottom row is
+   always 0 0 0 1. Stored by rows in either build, with the translation in
+   the last column. Every model and view matrix is one, and skipping the
+   constant row saves a quarter of the work and memory.
+
+   | m00 m01 m02 tx |
+   | m10 m11 m12 ty |
+   | m20 m21 m22 tz |
+   (  0   0   0   1 )
+
+   The in place translate, rotate and scale multiply on the right like the
+   mat4x4 versions do, so they only touch the columns they change.
+*/
+typedef vec4 mat3x4[3];
+typedef vec3 mat3x3[3];
+
+M_INLINE void mat3x4_mov(mat3x4 dest, mat3x4 const src) {
+  memcpy(dest, src, sizeof(mat3x4));
+}
+
+M_INLINE void mat3x4_identity(mat3x4 M) {
+  memset(M, 0, sizeof(mat3x4));
+  M[0][0] = 1.0f;
+  M[1][1] = 1.0f;
+  M[2][2] = 1.0f;
+}
+
+// drops the bottom row, which has to be 0 0 0 1
+M_INLINE void mat3x4_from_mat4x4(mat3x4 M, mat4x4 const src) {
+#if MATH_COLUMN_MAJOR
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 4; ++c) M[r][c] = M4(src, r, c);
+  }
+#else
+  memcpy(M, src, sizeof(mat3x4));
+#endif
+}
+
+M_INLINE void mat3x4_to_mat4x4(mat4x4 M, mat3x4 const src) {
+#if MATH_COLUMN_MAJOR
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 4; ++c) M4(M, r, c) = src[r][c];
+  }
+#else
+  memcpy(M, src, sizeof(mat3x4));
+#endif
+  M4(M, 3, 0) = 0.0f;
+  M4(M, 3, 1) = 0.0f;
+  M4(M, 3, 2) = 0.0f;
+  M4(M, 3, 3) = 1.0f;
+}
+
+M_INLINE void mat3x4_mul_ref(mat3x4 M, mat3x4 const a, mat3x4 const b) {
+  mat3x4 temp;
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 4; ++c) {
+      temp[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c];
+    }
+    temp[r][3] += a[r][3];
+  }
+  mat3x4_mov(M, temp);
+}
+
+// M = a * b for a general a and an affine b, such as projection * view
+M_INLINE void mat4x4_mul_mat3x4_ref(mat4x4 M, mat4x4 const a,
+                                    mat3x4 const b) {
+  mat4x4 temp;
+  for (u32 r = 0; r < 4; ++r) {
+    for (u32 c = 0; c < 4; ++c) {
+      M4(temp, r, c) = M4(a, r, 0) * b[0][c] + M4(a, r, 1) * b[1][c] +
+                       M4(a, r, 2) * b[2][c];
+    }
+    M4(temp, r, 3) += M4(a, r, 3);
+  }
+  mat4x4_mov(M, temp);
+}
+
+#if MATH_SIMD
+// the rows of b weighted by a row of a, the implicit bottom row of b only
+// adds a's last column to the translation
+M_INLINE __m128 math_affine_row(const f32* a, __m128 b0, __m128 b1,
+                                __m128 b2) {
+  __m128 s = _mm_mul_ps(_mm_set1_ps(a[0]), b0);
+  s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[1]), b1));
+  s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(a[2]), b2));
+  return _mm_add_ps(s, _mm_set_ps(a[3], 0.0f, 0.0f, 0.0f));
+}
+
+M_INLINE void mat3x4_mul(mat3x4 M, mat3x4 const a, mat3x4 const b) {
+  const __m128 b0 = _mm_loadu_ps(b[0]), b1 = _mm_loadu_ps(b[1]);
+  const __m128 b2 = _mm_loadu_ps(b[2]);
+  __m128 rows[3];
+  for (u32 r = 0; r < 3; ++r) rows[r] = math_affine_row(a[r], b0, b1, b2);
+  for (u32 r = 0; r < 3; ++r) _mm_storeu_ps(M[r], rows[r]);
+}
+
+#if MATH_COLUMN_MAJOR
+// the columns of a weighted by a column of b, whose implicit bottom row only
+// adds a's last column to the translation
+M_INLINE void mat4x4_mul_mat3x4(mat4x4 M, mat4x4 const a, mat3x4 const b) {
+  const __m128 a0 = _mm_loadu_ps(a[0]), a1 = _mm_loadu_ps(a[1]);
+  const __m128 a2 = _mm_loadu_ps(a[2]), a3 = _mm_loadu_ps(a[3]);
+  __m128 columns[4];
+  for (u32 c = 0; c < 4; ++c) {
+    __m128 s = _mm_mul_ps(a0, _mm_set1_ps(b[0][c]));
+    s = _mm_add_ps(s, _mm_mul_ps(a1, _mm_set1_ps(b[1][c])));
+    columns[c] = _mm_add_ps(s, _mm_mul_ps(a2, _mm_set1_ps(b[2][c])));
+  }
+  columns[3] = _mm_add_ps(columns[3], a3);
+  for (u32 c = 0; c < 4; ++c) _mm_storeu_ps(M[c], columns[c]);
+}
+#else
+M_INLINE void mat4x4_mul_mat3x4(mat4x4 M, mat4x4 const a, mat3x4 const b) {
+  const __m128 b0 = _mm_loadu_ps(b[0]), b1 = _mm_loadu_ps(b[1]);
+  const __m128 b2 = _mm_loadu_ps(b[2]);
+  __m128 rows[4];
+  for (u32 r = 0; r < 4; ++r) rows[r] = math_affine_row(a[r], b0, b1, b2);
+  for (u32 r = 0; r < 4; ++r) _mm_storeu_ps(M[r], rows[r]);
+}
+#endif
+#else
+M_INLINE void mat3x4_mul(mat3x4 M, mat3x4 const a, mat3x4 const b) {
+  mat3x4_mul_ref(M, a, b);
+}
+
+M_INLINE void mat4x4_mul_mat3x4(mat4x4 M, mat4x4 const a, mat3x4 const b) {
+  mat4x4_mul_mat3x4_ref(M, a, b);
+}
+#endif
+
+// r = M * (p, 1)
+M_INLINE void mat3x4_mul_point(vec3 r, mat3x4 const M, vec3 const p) {
+  vec3 temp;
+  for (u32 i = 0; i < 3; ++i) {
+    temp[i] = M[i][0] * p[0] + M[i][1] * p[1] + M[i][2] * p[2] + M[i][3];
+  }
+  memcpy(r, temp, sizeof(vec3));
+}
+
+// r = M * (v, 0), ignores the translation
+M_INLINE void mat3x4_mul_dir(vec3 r, mat3x4 const M, vec3 const v) {
+  vec3 temp;
+  for (u32 i = 0; i < 3; ++i) {
+    temp[i] = M[i][0] * v[0] + M[i][1] * v[1] + M[i][2] * v[2];
+  }
+  memcpy(r, temp, sizeof(vec3));
+}
+
+// M = M * T, only the translation column changes
+M_INLINE void mat3x4_translate(mat3x4 M, f32 x, f32 y, f32 z) {
+  for (u32 r = 0; r < 3; ++r) {
+    M[r][3] += M[r][0] * x + M[r][1] * y + M[r][2] * z;
+  }
+}
+
+// M = M * Rx, mixing columns 1 and 2. the rotations are the ones in the
+// mat4x4 versions above
+M_INLINE void mat3x4_rotate_x(mat3x4 M, f32 theta) {
+  const f32 s = sinf(theta), c = cosf(theta);
+  for (u32 r = 0; r < 3; ++r) {
+    const f32 m1 = M[r][1], m2 = M[r][2];
+    M[r][1] = m1 * c + m2 * s;
+    M[r][2] = m2 * c - m1 * s;
+  }
+}
+
+// M = M * Ry, mixing columns 0 and 2
+M_INLINE void mat3x4_rotate_y(mat3x4 M, f32 theta) {
+  const f32 s = sinf(theta), c = cosf(theta);
+  for (u32 r = 0; r < 3; ++r) {
+    const f32 m0 = M[r][0], m2 = M[r][2];
+    M[r][0] = m0 * c - m2 * s;
+    M[r][2] = m0 * s + m2 * c;
+  }
+}
+
+// M = M * Rz, mixing columns 0 and 1
+M_INLINE void mat3x4_rotate_z(mat3x4 M, f32 theta) {
+  const f32 s = sinf(theta), c = cosf(theta);
+  for (u32 r = 0; r < 3; ++r) {
+    const f32 m0 = M[r][0], m1 = M[r][1];
+    M[r][0] = m0 * c + m1 * s;
+    M[r][1] = m1 * c - m0 * s;
+  }
+}
+
+// M = M * S, scaling the first three columns
+M_INLINE void mat3x4_scale_aniso(mat3x4 M, f32 sx, f32 sy, f32 sz) {
+  for (u32 r = 0; r < 3; ++r) {
+    M[r][0] *= sx;
+    M[r][1] *= sy;
+    M[r][2] *= sz;
+  }
+}
+
+// same view matrix as mat4x4_look_at
+M_INLINE void mat3x4_look_at(mat3x4 M, vec3 const eye, vec3 const center,
+                             vec3 const up) {
+  vec3 f, s, t;
+  vec3_sub(f, center, eye);
+  vec3_normalize(f, f);
+  vec3_cross(s, f, up);
+  vec3_normalize(s, s);
+  vec3_cross(t, s, f);
+
+  M[0][0] = s[0];
+  M[0][1] = s[1];
+  M[0][2] = s[2];
+  M[0][3] = -vec3_dot(s, eye);
+
+  M[1][0] = t[0];
+  M[1][1] = t[1];
+  M[1][2] = t[2];
+  M[1][3] = -vec3_dot(t, eye);
+
+  M[2][0] = -f[0];
+  M[2][1] = -f[1];
+  M[2][2] = -f[2];
+  M[2][3] = vec3_dot(f, eye);
+}
+
+/*
+   The cofactors of the upper 3x3 A. Each entry is the determinant left when
+   its row and column are crossed out, with the checkerboard sign, which for
+   a 3x3 is the cross product of the other two rows:
+
+   C = | a1 x a2 |
+       | a2 x a0 |
+       | a0 x a1 |
+
+   and det(A) = a0 . (a1 x a2). The inverse is C transposed over det(A), so
+   the inverse transpose that normals need is C over det(A) as is.
+*/
+M_INLINE f32 mat3x4_cofactors(mat3x3 C, mat3x4 const M) {
+  vec3 a0 = {M[0][0], M[0][1], M[0][2]};
+  vec3 a1 = {M[1][0], M[1][1], M[1][2]};
+  vec3 a2 = {M[2][0], M[2][1], M[2][2]};
+  vec3_cross(C[0], a1, a2);
+  vec3_cross(C[1], a2, a0);
+  vec3_cross(C[2], a0, a1);
+  return vec3_dot(a0, C[0]);
+}
+
+// inverse of any invertible affine transform. the inverse of
+// [A | t] is [A^-1 | -A^-1 t]
+M_INLINE bool mat3x4_invert(mat3x4 M, mat3x4 const src) {
+  mat3x3 C;
+  const f32 det = mat3x4_cofactors(C, src);
+  if (fabsf(det) < FLOAT_EPSILON) return false;
+
+  const f32 inv_det = 1.0f / det;
+  const vec3 t = {src[0][3], src[1][3], src[2][3]};
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) M[r][c] = C[c][r] * inv_det;
+  }
+  for (u32 r = 0; r < 3; ++r) {
+    M[r][3] = -(M[r][0] * t[0] + M[r][1] * t[1] + M[r][2] * t[2]);
+  }
+  return true;
+}
+
+// inverse of a rotation and translation with no scale, where A^-1 is the
+// transpose of A, such as a camera's placement, whose inverse is its view
+M_INLINE void mat3x4_invert_rigid(mat3x4 M, mat3x4 const src) {
+  mat3x4 inv;
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) inv[r][c] = src[c][r];
+  }
+  for (u32 r = 0; r < 3; ++r) {
+    inv[r][3] = -(inv[r][0] * src[0][3] + inv[r][1] * src[1][3] +
+                  inv[r][2] * src[2][3]);
+  }
+  mat3x4_mov(M, inv);
+}
+
+// transforms normals, (A^-1)^T of the upper 3x3 so non uniform scale keeps
+// them perpendicular to their surface. a singular A gives the identity and
+// false
+M_INLINE bool mat3x4_normal_matrix(mat3x3 N, mat3x4 const M) {
+  mat3x3 C;
+  const f32 det = mat3x4_cofactors(C, M);
+  if (fabsf(det) < FLOAT_EPSILON) {
+    memset(N, 0, sizeof(mat3x3));
+    N[0][0] = N[1][1] = N[2][2] = 1.0f;
+    return false;
+  }
+
+  const f32 inv_det = 1.0f / det;
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) N[r][c] = C[r][c] * inv_det;
+  }
+  return true;
+}
+
+// the normal matrix of a general transform, from its upper 3x3 alone
+M_INLINE bool mat4x4_normal_matrix(mat3x3 N, mat4x4 const M) {
+  mat3x4 affine;
+  mat3x4_from_mat4x4(affine, M);
+  return mat3x4_normal_matrix(N, affine);
+}
+
+/*
+   Quaternions, x y z w with w the real part. The unit quaternion
+
+   (sin(a/2) * axis, cos(a/2))
+
+   rotates by a radians around a unit axis. Like matrices, q * p rotates by p
+   and then by q. q and -q are the same rotation, which the interpolations
+   account for by taking the shorter way around.
+*/
+typedef f32 quat[4];
+
+M_INLINE void quat_identity(quat q) {
+  q[0] = 0.0f;
+  q[1] = 0.0f;
+  q[2] = 0.0f;
+  q[3] = 1.0f;
+}
+
+// angle within the domain of fast_sincosf
+M_INLINE void quat_from_axis_angle(quat q, vec3 const axis, f32 angle) {
+  f32 s, c;
+  fast_sincosf(angle * 0.5f, &s, &c);
+  q[0] = axis[0] * s;
+  q[1] = axis[1] * s;
+  q[2] = axis[2] * s;
+  q[3] = c;
+}
+
+M_INLINE void quat_mul(quat r, quat const a, quat const b) {
+  quat temp = {
+      a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+      a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+      a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+      a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2],
+  };
+  memcpy(r, temp, sizeof(quat));
+}
+
+M_INLINE void quat_normalize(quat r, quat const q) { vec4_normalize(r, q); }
+
+// the inverse of a unit quaternion
+M_INLINE void quat_conjugate(quat r, quat const q) {
+  r[0] = -q[0];
+  r[1] = -q[1];
+  r[2] = -q[2];
+  r[3] = q[3];
+}
+
+// r = q * v * q^-1 for a unit q, without building the matrix:
+// t = 2 (u x v), r = v + w t + u x t with u the imaginary part
+M_INLINE void quat_rotate(vec3 r, quat const q, vec3 const v) {
+  vec3 t, u_t;
+  vec3_cross(t, q, v);
+  vec3_scale(t, t, 2.0f);
+  vec3_cross(u_t, q, t);
+  for (u32 i = 0; i < 3; ++i) r[i] = v[i] + q[3] * t[i] + u_t[i];
+}
+
+// straight line between a and b, renormalized. the angle doesn't change at
+// a constant rate but stays within 0.1% of slerp for steps under 30 degrees,
+// which is every per frame blend. a and b must not be opposite rotations
+M_INLINE void quat_nlerp(quat r, quat const a, quat const b, f32 t) {
+  const f32 wb = vec4_dot(a, b) < 0.0f ? -t : t;
+  const f32 wa = 1.0f - t;
+  quat temp;
+  for (u32 i = 0; i < 4; ++i) temp[i] = a[i] * wa + b[i] * wb;
+  vec4_scale(r, temp, fast_rsqrtf(vec4_dot(temp, temp)));
+}
+
+// constant angular velocity from a to b. nearly equal rotations fall back to
+// nlerp, where sin(theta) would lose all its precision
+M_INLINE void quat_slerp(quat r, quat const a, quat const b, f32 t) {
+  f32 d = vec4_dot(a, b);
+  f32 sign = 1.0f;
+  if (d < 0.0f) {
+    d = -d;
+    sign = -1.0f;
+  }
+  if (d > 0.9995f) {
+    quat_nlerp(r, a, b, t);
+    return;
+  }
+
+  const f32 theta = acosf(d), inv_sin = 1.0f / sinf(theta);
+  const f32 wa = sinf((1.0f - t) * theta) * inv_sin;
+  const f32 wb = sinf(t * theta) * inv_sin * sign;
+  for (u32 i = 0; i < 4; ++i) r[i] = a[i] * wa + b[i] * wb;
+}
+
+/*
+   The rotation of a unit quaternion as a matrix, with no translation:
+
+   | 1 - 2(yy + zz)   2(xy - wz)       2(xz + wy)     |
+   | 2(xy + wz)       1 - 2(xx + zz)   2(yz - wx)     |
+   | 2(xz - wy)       2(yz + wx)       1 - 2(xx + yy) |
+*/
+M_INLINE void quat_to_mat3x4(mat3x4 M, quat const q) {
+  const f32 x2 = q[0] + q[0], y2 = q[1] + q[1], z2 = q[2] + q[2];
+  const f32 xx = q[0] * x2, yy = q[1] * y2, zz = q[2] * z2;
+  const f32 xy = q[0] * y2, xz = q[0] * z2, yz = q[1] * z2;
+  const f32 wx = q[3] * x2, wy = q[3] * y2, wz = q[3] * z2;
+
+  M[0][0] = 1.0f - (yy + zz);
+  M[0][1] = xy - wz;
+  M[0][2] = xz + wy;
+  M[0][3] = 0.0f;
+  M[1][0] = xy + wz;
+  M[1][1] = 1.0f - (xx + zz);
+  M[1][2] = yz - wx;
+  M[1][3] = 0.0f;
+  M[2][0] = xz - wy;
+  M[2][1] = yz + wx;
+  M[2][2] = 1.0f - (xx + yy);
+  M[2][3] = 0.0f;
+}
 
 #endif
@@ -0,0 +1,180 @@
+#ifndef _LIB_POOL_H
+#define _LIB_POOL_H
+
+#include <string.h>
+
+#include "macros.h"
+#include "math.h"
+#include "misc.h"
+#include "types.h"
+
+/*
+generational slot map: elements live packed in one dense array and are
+referred to by stable handles, so iteration is a linear walk and a handle to
+a removed element is detected instead of dangling.
+
+usage:
+#include "c-lib/pool.h"
+
+typedef struct { int hp; } enemy_t;
+
+int main() {
+  pool_t enemies;
+  pool_init(&enemies, sizeof(enemy_t), 64);
+
+  handle_t a = pool_create(&enemies), b = pool_create(&enemies);
+  ((enemy_t*)pool_get(&enemies, a))->hp = 10;
+  ((enemy_t*)pool_get(&enemies, b))->hp = 20;
+
+  pool_remove(&enemies, a);
+  // prints (nil): a is stale even once its slot is reused
+  printf("%p\n", pool_get(&enemies, a));
+
+  // output: 20
+  pool_each(&enemies, enemy_t, enemy) {
+    printf("%d ", enemy->hp);
+  }
+
+  pool_destroy(&enemies);
+  return 0;
+}
+*/
+
+// a handle is a slot index in the low bits and the slot generation above it
+#define POOL_INDEX_BITS 20
+#define POOL_INDEX_MASK ((1u << POOL_INDEX_BITS) - 1)
+#define POOL_MAX_SIZE (1u << POOL_INDEX_BITS)
+#define POOL_GENERATION_MASK ((1u << (32 - POOL_INDEX_BITS)) - 1)
+#define POOL_MIN_CAP 16
+#define POOL_NONE 0xFFFFFFFF
+
+#define HANDLE_NULL 0 // generations start at 1, so no live handle is 0
+
+typedef u32 handle_t;
+
+typedef struct {
+  u32 dense;      // element index while alive, next free slot once removed
+  u32 generation; // bumped on every remove
+} pool_slot_t;
+
+typedef struct {
+  u8* data;         // dense elements, t_size each
+  u32* dense_slots; // slot owning each dense element
+  pool_slot_t* slots;
+  size_t t_size;
+  u32 size, capacity; // dense elements
+  u32 slot_count, slot_capacity;
+  u32 free_head; // POOL_NONE when every slot is in use
+} pool_t;
+
+M_INLINE u32 handle_index(handle_t h) { return h & POOL_INDEX_MASK; }
+M_INLINE u32 handle_generation(handle_t h) { return h >> POOL_INDEX_BITS; }
+
+// number of live elements
+M_INLINE u32 pool_size(const pool_t* pool) { return pool->size; }
+
+// element at a dense index, only valid until the next create or remove
+M_INLINE void* pool_at(const pool_t* pool, u32 i) {
+  return pool->data + (size_t)i * pool->t_size;
+}
+
+// handle of the element at a dense index
+M_INLINE handle_t pool_handle_at(const pool_t* pool, u32 i) {
+  u32 slot = pool->dense_slots[i];
+  return (pool->slots[slot].generation << POOL_INDEX_BITS) | slot;
+}
+
+// resolve a handle, NULL if it was removed (or never created)
+M_INLINE void* pool_get(const pool_t* pool, handle_t h) {
+  u32 slot = handle_index(h);
+  if (slot >= pool->slot_count ||
+      pool->slots[slot].generation != handle_generation(h)) {
+    return NULL;
+  }
+  return pool_at(pool, pool->slots[slot].dense);
+}
+
+// iteration macro, in dense order
+#define pool_each(_pool, _T, _it) \
+  for (_T *_it = (_T*)(_pool)->data, *_end = _it + (_pool)->size; \
+       _it < _end; ++_it)
+
+static M_UNUSED void pool_init(pool_t* pool, size_t t_size, u32 capacity) {
+  capacity = max(capacity, POOL_MIN_CAP);
+  *pool = (pool_t){
+      .data = (u8*)malloc(t_size * capacity),
+      .dense_slots = (u32*)malloc(sizeof(u32) * capacity),
+      .slots = (pool_slot_t*)malloc(sizeof(pool_slot_t) * capacity),
+      .t_size = t_size,
+      .capacity = capacity,
+      .slot_capacity = capacity,
+      .free_head = POOL_NONE,
+  };
+  ASSERT(pool->data && pool->dense_slots && pool->slots);
+}
+
+static M_UNUSED void pool_destroy(pool_t* pool) {
+  free(pool->data);
+  free(pool->dense_slots);
+  free(pool->slots);
+  *pool = (pool_t){0};
+}
+
+// adds a zeroed element, O(1) amortized
+static M_UNUSED handle_t pool_create(pool_t* pool) {
+  u32 slot = pool->free_head;
+  if (slot != POOL_NONE) {
+    pool->free_head = pool->slots[slot].dense;
+  } else {
+    ASSERT(pool->slot_count < POOL_MAX_SIZE, "pool is full");
+    if (pool->slot_count == pool->slot_capacity) {
+      pool->slot_capacity *= 2;
+      pool->slots = (pool_slot_t*)realloc(
+          pool->slots, sizeof(pool_slot_t) * pool->slot_capacity);
+      ASSERT(pool->slots);
+    }
+    slot = pool->slot_count++;
+    pool->slots[slot].generation = 1;
+  }
+
+  if (pool->size == pool->capacity) {
+    pool->capacity *= 2;
+    pool->data = (u8*)realloc(pool->data, pool->t_size * pool->capacity);
+    pool->dense_slots =
+        (u32*)realloc(pool->dense_slots, sizeof(u32) * pool->capacity);
+    ASSERT(pool->data && pool->dense_slots);
+  }
+
+  u32 i = pool->size++;
+  pool->slots[slot].dense = i;
+  pool->dense_slots[i] = slot;
+  memset(pool_at(pool, i), 0, pool->t_size);
+  return (pool->slots[slot].generation << POOL_INDEX_BITS) | slot;
+}
+
+// removes an element, the last dense element moves into its place, O(1)
+static M_UNUSED void pool_remove(pool_t* pool, handle_t h) {
+  ASSERT(pool_get(pool, h), "stale pool handle %u", h);
+  u32 slot = handle_index(h);
+  u32 i = pool->slots[slot].dense, last = --pool->size;
+  if (i != last) {
+    memcpy(pool_at(pool, i), pool_at(pool, last), pool->t_size);
+    pool->dense_slots[i] = pool->dense_slots[last];
+    pool->slots[pool->dense_slots[i]].dense = i;
+  }
+
+  // generation 0 is skipped on wrap so HANDLE_NULL never resolves
+  u32 generation = (pool->slots[slot].generation + 1) & POOL_GENERATION_MASK;
+  pool->slots[slot].generation = generation ? generation : 1;
+  pool->slots[slot].dense = pool->free_head;
+  pool->free_head = slot;
+}
+
+// removes every element, outstanding handles become stale
+static M_UNUSED void pool_clear(pool_t* pool) {
+  while (pool->size > 0) {
+    pool_remove(pool, pool_handle_at(pool, pool->size - 1));
+  }
+}
+
+#endif
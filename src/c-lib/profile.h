@@ -0,0 +1,265 @@
+#ifndef _LIB_PROFILE_H
+#define _LIB_PROFILE_H
+
+// scoped cpu profiler writing chrome trace event json, open the file in
+// ui.perfetto.dev or chrome://tracing
+//
+// compiled in with CLIB_PROFILE, otherwise every macro below expands to
+// nothing. exactly one translation unit defines CLIB_PROFILE_IMPL before
+// including this header
+//
+//   void update(void) {
+//     PROFILE_FUNC();
+//     { PROFILE_SCOPE("physics"); ... }
+//   }
+//
+// each thread records into its own buffer, only the owning thread writes it,
+// so recording takes no locks. names must outlive the capture, string
+// literals and __func__ do
+
+#include "macros.h"
+#include "types.h"
+
+#define PROFILE_MAX_EVENTS (1 << 16) // per thread and capture, then dropped
+
+#ifdef CLIB_PROFILE
+
+typedef struct {
+  const char* name;
+  u64 start; // ns, 0 if the capture was not running when the scope opened
+} profile_scope_t;
+
+profile_scope_t profile_scope_begin(const char* name);
+void profile_scope_end(profile_scope_t* scope);
+
+// names the calling thread in the trace
+void profile_thread_name(const char* name);
+// starts recording right away and writes the trace to path once frames
+// frame marks have passed. ignored while a capture is already running
+void profile_capture(u32 frames, const char* path);
+// marks the end of a frame, on the thread that drives the capture
+void profile_frame(void);
+
+#define PROFILE_SCOPE(_name)                                            \
+  profile_scope_t _CONCAT(_profile_scope_, __LINE__)                    \
+      __attribute__((cleanup(profile_scope_end))) =                     \
+          profile_scope_begin(_name)
+#define PROFILE_FUNC() PROFILE_SCOPE(__func__)
+
+#define PROFILE_THREAD_NAME(_name) profile_thread_name(_name)
+#define PROFILE_CAPTURE(_frames, _path) profile_capture((_frames), (_path))
+#define PROFILE_FRAME() profile_frame()
+
+#else
+
+#define PROFILE_SCOPE(_name)
+#define PROFILE_FUNC()
+#define PROFILE_THREAD_NAME(_name)
+#define PROFILE_CAPTURE(_frames, _path) ((void)(_frames), (void)(_path))
+#define PROFILE_FRAME()
+
+#endif
+
+#if defined(CLIB_PROFILE) && defined(CLIB_PROFILE_IMPL)
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "misc.h"
+
+typedef struct {
+  const char* name;
+  u64 start, duration; // ns
+} profile_event_t;
+
+typedef struct profile_thread_s {
+  profile_event_t events[PROFILE_MAX_EVENTS];
+  _Atomic u32 count;      // published events, written by the owner only
+  _Atomic u32 generation; // capture the events belong to
+  u32 dropped;
+  u32 id;
+  _Atomic(const char*) name;
+  struct profile_thread_s* next;
+} profile_thread_t;
+
+static struct {
+  _Atomic(profile_thread_t*) threads; // every thread that ever recorded
+  _Atomic u32 thread_count;
+  _Atomic bool recording;
+  _Atomic u32 generation;
+  u32 frames_left;
+  u64 frame_start;
+  char path[256];
+  struct {
+    u64 start, duration;
+  } frames[256]; // the longest capture
+  u32 frame_count;
+} profile;
+
+static _Thread_local profile_thread_t* profile_local;
+
+// absolute, so every thread shares the same origin
+static u64 profile_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static profile_thread_t* profile_thread(void) {
+  if (profile_local) return profile_local;
+
+  profile_thread_t* thread = calloc(1, sizeof(profile_thread_t));
+  if (!thread) return NULL;
+  thread->id = atomic_fetch_add(&profile.thread_count, 1);
+
+  // push onto the list, the only shared write a thread ever does
+  profile_thread_t* head = atomic_load(&profile.threads);
+  do {
+    thread->next = head;
+  } while (!atomic_compare_exchange_weak(&profile.threads, &head, thread));
+  profile_local = thread;
+  return thread;
+}
+
+profile_scope_t profile_scope_begin(const char* name) {
+  bool recording = atomic_load_explicit(&profile.recording,
+                                        memory_order_relaxed);
+  return (profile_scope_t){name, recording ? profile_now() : 0};
+}
+
+void profile_scope_end(profile_scope_t* scope) {
+  if (!scope->start) return;
+  const u64 end = profile_now();
+  profile_thread_t* thread = profile_thread();
+  if (!thread) return;
+
+  // the first event of a new capture forgets the previous one
+  const u32 generation = atomic_load(&profile.generation);
+  u32 count = atomic_load_explicit(&thread->count, memory_order_relaxed);
+  if (atomic_load_explicit(&thread->generation, memory_order_relaxed) !=
+      generation) {
+    count = 0;
+    thread->dropped = 0;
+    atomic_store_explicit(&thread->generation, generation,
+                          memory_order_relaxed);
+  }
+  if (count == PROFILE_MAX_EVENTS) {
+    ++thread->dropped;
+    return;
+  }
+
+  thread->events[count] = (profile_event_t){
+      scope->name,
+      scope->start,
+      end - scope->start,
+  };
+  atomic_store_explicit(&thread->count, count + 1, memory_order_release);
+}
+
+void profile_thread_name(const char* name) {
+  profile_thread_t* thread = profile_thread();
+  if (thread) atomic_store(&thread->name, name);
+}
+
+void profile_capture(u32 frames, const char* path) {
+  if (atomic_load(&profile.recording) || frames == 0) return;
+  profile.frames_left =
+      frames < ARRLEN(profile.frames) ? frames : ARRLEN(profile.frames);
+  snprintf(profile.path, sizeof(profile.path), "%s", path);
+  profile.frame_count = 0;
+  profile.frame_start = profile_now();
+
+  // a new generation so threads drop whatever the last capture left
+  atomic_fetch_add(&profile.generation, 1);
+  atomic_store(&profile.recording, true);
+  LOG("Profiling %u frames to %s", profile.frames_left, profile.path);
+}
+
+// names are c strings the program chose, so only quotes need escaping
+static void profile_write_string(FILE* fp, const char* s) {
+  fputc('"', fp);
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') fputc('\\', fp);
+    fputc(*s, fp);
+  }
+  fputc('"', fp);
+}
+
+static void profile_write(u64 origin) {
+  FILE* fp = fopen(profile.path, "w");
+  if (!fp) {
+    ERROR("cannot write profile: %s", profile.path);
+    return;
+  }
+
+  const u32 generation = atomic_load(&profile.generation);
+  u32 events = 0, dropped = 0;
+  fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+              "\"args\": {\"name\": \"frames\"}}");
+  for (u32 i = 0; i < profile.frame_count; ++i) {
+    fprintf(fp,
+            ",\n{\"name\": \"frame %u\", \"ph\": \"X\", \"pid\": 1, "
+            "\"tid\": 0, \"ts\": %.3f, \"dur\": %.3f}",
+            i, (profile.frames[i].start - origin) / 1000.0,
+            profile.frames[i].duration / 1000.0);
+  }
+
+  fprintf(fp, ",\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, "
+              "\"args\": {\"name\": \"threads\"}}");
+  for (profile_thread_t* thread = atomic_load(&profile.threads); thread;
+       thread = thread->next) {
+    if (atomic_load(&thread->generation) != generation) continue;
+    const char* name = atomic_load(&thread->name);
+    if (name) {
+      fprintf(fp,
+              ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 2, "
+              "\"tid\": %u, \"args\": {\"name\": ",
+              thread->id);
+      profile_write_string(fp, name);
+      fprintf(fp, "}}");
+    }
+
+    const u32 count = atomic_load_explicit(&thread->count,
+                                           memory_order_acquire);
+    for (u32 i = 0; i < count; ++i) {
+      const profile_event_t* event = &thread->events[i];
+      if (event->start < origin) continue; // opened before the capture
+      fprintf(fp, ",\n{\"name\": ");
+      profile_write_string(fp, event->name);
+      fprintf(fp,
+              ", \"ph\": \"X\", \"pid\": 2, \"tid\": %u, \"ts\": %.3f, "
+              "\"dur\": %.3f}",
+              thread->id, (event->start - origin) / 1000.0,
+              event->duration / 1000.0);
+      ++events;
+    }
+    dropped += thread->dropped;
+  }
+  fprintf(fp, "\n]}\n");
+  fclose(fp);
+
+  LOG("Wrote %u profile events over %u frames to %s", events,
+      profile.frame_count, profile.path);
+  if (dropped) {
+    WARN("dropped %u profile events, PROFILE_MAX_EVENTS is %u", dropped,
+         PROFILE_MAX_EVENTS);
+  }
+}
+
+void profile_frame(void) {
+  if (!atomic_load(&profile.recording)) return;
+  const u64 now = profile_now();
+  profile.frames[profile.frame_count].start = profile.frame_start;
+  profile.frames[profile.frame_count].duration = now - profile.frame_start;
+  ++profile.frame_count;
+  profile.frame_start = now;
+  if (--profile.frames_left) return;
+
+  // scopes still open on other threads finish into a capture nobody reads
+  atomic_store(&profile.recording, false);
+  profile_write(profile.frames[0].start);
+}
+#endif
+#endif
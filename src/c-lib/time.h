@@ -43,5 +43,28 @@ M_INLINE u64 time_ns(void) {
 
 M_INLINE f64 time_s(void) { return time_ns() / 1000000000.0; }
 
+#elif CLIB_TIME_POSIX
+#include <time.h>
+
+// monotonic, and usable without a window system
+static u64 time_start = 0;
+
+M_INLINE f64 time_s(void);
+M_INLINE u64 time_ns(void);
+
+M_INLINE u64 time_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  const u64 now = (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+
+  if (!time_start) {
+    time_start = now;
+  }
+
+  return now - time_start;
+}
+
+M_INLINE f64 time_s(void) { return time_ns() / 1000000000.0; }
+
 #endif
 #endif
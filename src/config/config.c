@@ -7,11 +7,15 @@
 #include "../file_io.h"
 #include "../state.h"
 
+#define DEFAULT_FRAME_RATE 0 // swaps already wait for vsync
+#define DEFAULT_SIM_RATE 60
+
 static const keymap_t glfw_keymap[] = {
     {"Left", GLFW_KEY_LEFT}, {"Right", GLFW_KEY_RIGHT},   {"Up", GLFW_KEY_UP},
     {"Down", GLFW_KEY_DOWN}, {"Escape", GLFW_KEY_ESCAPE}, {"F", GLFW_KEY_F},
     {"O", GLFW_KEY_O},       {"Space", GLFW_KEY_SPACE},   {"W", GLFW_KEY_W},
     {"A", GLFW_KEY_A},       {"S", GLFW_KEY_S},           {"D", GLFW_KEY_D},
+    {"P", GLFW_KEY_P},
 };
 static const keybind_info_t config_info[] = {
     // NOTE: this order should match the order of the input_key_t enums
@@ -27,19 +31,20 @@ static const keybind_info_t config_info[] = {
     {INPUT_KEY_S, "s", "S"},
     {INPUT_KEY_D, "d", "D"},
     {INPUT_KEY_SPACE, "jump", "Space"},
+    {INPUT_KEY_PROFILE, "profile", "P"},
 };
 static const size_t glfw_keymap_size = sizeof(glfw_keymap) / sizeof(keymap_t);
 static const size_t config_size = sizeof(config_info) / sizeof(keybind_info_t);
 
-static void config_get_value(char* dest, u32 dest_size, const char* conf_buf,
+// false if the key is not in the config
+static bool config_get_value(char* dest, u32 dest_size, const char* conf_buf,
                              const char* value) {
   const char* search_start = conf_buf;
   const size_t key_len = strlen(value);
 
   while (1) {
     const char* key_ptr = strstr(search_start, value);
-
-    ASSERT(key_ptr, "couldn't find the config key: %s\n", value);
+    if (!key_ptr) return false;
 
     // check if the found occurrence is a valid key
     // a valid key is at the start of a line and is a whole word
@@ -64,7 +69,7 @@ static void config_get_value(char* dest, u32 dest_size, const char* conf_buf,
       }
       *dest_ptr = '\0'; // null-terminate the destination string
 
-      return;
+      return true;
     }
     // else continue searching, false position (ex. 'w' in 'down')
     search_start = key_ptr + 1;
@@ -84,18 +89,42 @@ static void config_load_controls(const char* conf_buf) {
   char key_name_buf[64];
   for (size_t i = 0; i < config_size; ++i) {
     const keybind_info_t* info = &config_info[i];
-    config_get_value(key_name_buf, sizeof(key_name_buf), conf_buf,
-                     info->name_in_config);
+    // configs written before a key existed keep working with its default
+    if (!config_get_value(key_name_buf, sizeof(key_name_buf), conf_buf,
+                          info->name_in_config)) {
+      WARN("no config key %s, using %s", info->name_in_config,
+           info->default_key);
+      config_key_bind(info->key, info->default_key);
+      continue;
+    }
     config_key_bind(info->key, key_name_buf);
   }
 }
 
+// optional, older configs don't have the [time] section
+static void config_load_time(const char* conf_buf) {
+  char value[32];
+  state.config.frame_rate = DEFAULT_FRAME_RATE;
+  if (config_get_value(value, sizeof(value), conf_buf, "frame_rate")) {
+    state.config.frame_rate = (u32)strtoul(value, NULL, 10);
+  }
+  state.config.sim_rate = DEFAULT_SIM_RATE;
+  if (config_get_value(value, sizeof(value), conf_buf, "sim_rate")) {
+    state.config.sim_rate = (u32)strtoul(value, NULL, 10);
+  }
+  if (state.config.sim_rate == 0) {
+    WARN("sim_rate can't be 0, using %u", DEFAULT_SIM_RATE);
+    state.config.sim_rate = DEFAULT_SIM_RATE;
+  }
+}
+
 static i32 config_load(void) {
   file_t config_file = io_file_read("./config.ini");
   if (!config_file.is_valid) {
     return -1;
   }
   config_load_controls(config_file.data);
+  config_load_time(config_file.data);
   free(config_file.data);
   return 0;
 }
@@ -109,6 +138,10 @@ static void write_default_config(void) {
              info->default_key);
     strcat(buffer, line);
   }
+  char line[64];
+  snprintf(line, sizeof(line), "\n[time]\nframe_rate = %u\nsim_rate = %u\n",
+           DEFAULT_FRAME_RATE, DEFAULT_SIM_RATE);
+  strcat(buffer, line);
   io_file_write(buffer, strlen(buffer), "./config.ini");
   LOG("Wrote and loaded a default config to disk at: ./config.ini");
 }
@@ -5,6 +5,8 @@
 
 typedef struct {
   u32 keybinds[INPUT_KEY_COUNT];
+  u32 frame_rate; // paced target, 0 leaves it to vsync
+  u32 sim_rate;   // fixed simulation steps per second
 } config_t;
 
 typedef struct {
@@ -13,6 +13,7 @@ typedef enum {
   INPUT_KEY_S,
   INPUT_KEY_D,
   INPUT_KEY_SPACE,
+  INPUT_KEY_PROFILE,
 
   INPUT_KEY_COUNT,
 } input_key_t;
@@ -0,0 +1,139 @@
+#include "cull.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_LANES 8
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define CULL_LANES 4
+#else
+#define CULL_LANES 1
+#endif
+
+void frustum_extract(frustum_t* frustum, mat4x4 view_proj) {
+  vec4 rows[4];
+  for (u32 r = 0; r < 4; ++r) {
+    for (u32 c = 0; c < 4; ++c) rows[r][c] = M4(view_proj, r, c);
+  }
+
+  // gribb/hartmann: each plane is the w row plus or minus one of the others
+  for (u32 i = 0; i < 3; ++i) {
+    vec4_add(frustum->planes[i * 2 + 0], rows[3], rows[i]);
+    vec4_sub(frustum->planes[i * 2 + 1], rows[3], rows[i]);
+  }
+
+  // normalized so the plane distance compares directly against a radius
+  for (u32 i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+    f32* p = frustum->planes[i];
+    f32 len = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    vec4_scale(p, p, 1.0f / len);
+  }
+}
+
+void cull_batch_init(cull_batch_t* batch) {
+  *batch = (cull_batch_t){
+      .x = dynlist_create(f32, 1024),
+      .y = dynlist_create(f32, 1024),
+      .z = dynlist_create(f32, 1024),
+      .radius = dynlist_create(f32, 1024),
+      .visible = dynlist_create(u8, 1024),
+  };
+}
+
+void cull_batch_destroy(cull_batch_t* batch) {
+  dynlist_destroy(batch->x);
+  dynlist_destroy(batch->y);
+  dynlist_destroy(batch->z);
+  dynlist_destroy(batch->radius);
+  dynlist_destroy(batch->visible);
+}
+
+void cull_batch_resize(cull_batch_t* batch, u32 n) {
+  dynlist_resize_no_contract(batch->x, n);
+  dynlist_resize_no_contract(batch->y, n);
+  dynlist_resize_no_contract(batch->z, n);
+  dynlist_resize_no_contract(batch->radius, n);
+  dynlist_resize_no_contract(batch->visible, n);
+}
+
+static bool sphere_visible(const frustum_t* frustum, f32 x, f32 y, f32 z,
+                           f32 radius) {
+  for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    const f32* plane = frustum->planes[p];
+    f32 d = plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+    if (d + radius < 0.0f) return false;
+  }
+  return true;
+}
+
+#if CULL_LANES == 8
+typedef __m256 lanes_t;
+#define LANES_SET1 _mm256_set1_ps
+#define LANES_LOAD _mm256_loadu_ps
+#define LANES_ADD _mm256_add_ps
+#define LANES_MUL _mm256_mul_ps
+#define LANES_AND _mm256_and_ps
+#define LANES_GE(_a, _b) _mm256_cmp_ps((_a), (_b), _CMP_GE_OQ)
+#define LANES_MASK _mm256_movemask_ps
+#elif CULL_LANES == 4
+typedef __m128 lanes_t;
+#define LANES_SET1 _mm_set1_ps
+#define LANES_LOAD _mm_loadu_ps
+#define LANES_ADD _mm_add_ps
+#define LANES_MUL _mm_mul_ps
+#define LANES_AND _mm_and_ps
+#define LANES_GE _mm_cmpge_ps
+#define LANES_MASK _mm_movemask_ps
+#endif
+
+#if CULL_LANES > 1
+// all ones in the lanes whose sphere is on the inner side of the plane
+static inline lanes_t lanes_plane_test(const lanes_t plane[4], lanes_t x,
+                                       lanes_t y, lanes_t z, lanes_t r) {
+  lanes_t d = LANES_ADD(LANES_MUL(plane[0], x), plane[3]);
+  d = LANES_ADD(d, LANES_MUL(plane[1], y));
+  d = LANES_ADD(d, LANES_MUL(plane[2], z));
+  return LANES_GE(LANES_ADD(d, r), LANES_SET1(0.0f));
+}
+#endif
+
+// returns the number of visible spheres in the range
+u32 cull_batch_run(cull_batch_t* batch, const frustum_t* frustum, u32 begin,
+                   u32 end) {
+  ASSERT(end <= dynlist_size(batch->x));
+  const u32 n = end;
+  u32 i = begin, visible = 0;
+
+#if CULL_LANES > 1
+  // the planes are splatted once, then each group of spheres costs 6 tests
+  lanes_t planes[FRUSTUM_PLANE_COUNT][4];
+  for (u32 p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    for (u32 c = 0; c < 4; ++c) {
+      planes[p][c] = LANES_SET1(frustum->planes[p][c]);
+    }
+  }
+
+  for (; i + CULL_LANES <= n; i += CULL_LANES) {
+    lanes_t x = LANES_LOAD(&batch->x[i]), y = LANES_LOAD(&batch->y[i]),
+            z = LANES_LOAD(&batch->z[i]), r = LANES_LOAD(&batch->radius[i]);
+
+    lanes_t inside = lanes_plane_test(planes[0], x, y, z, r);
+    for (u32 p = 1; p < FRUSTUM_PLANE_COUNT; ++p) {
+      inside = LANES_AND(inside, lanes_plane_test(planes[p], x, y, z, r));
+    }
+
+    u32 mask = (u32)LANES_MASK(inside);
+    for (u32 lane = 0; lane < CULL_LANES; ++lane) {
+      batch->visible[i + lane] = (mask >> lane) & 1;
+    }
+    visible += __builtin_popcount(mask);
+  }
+#endif
+
+  for (; i < n; ++i) {
+    batch->visible[i] = sphere_visible(frustum, batch->x[i], batch->y[i],
+                                       batch->z[i], batch->radius[i]);
+    visible += batch->visible[i];
+  }
+  return visible;
+}
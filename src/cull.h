@@ -0,0 +1,40 @@
+#pragma once
+
+#include "c-lib/dynlist.h"
+#include "c-lib/math.h"
+#include "c-lib/types.h"
+
+typedef enum {
+  FRUSTUM_LEFT,
+  FRUSTUM_RIGHT,
+  FRUSTUM_BOTTOM,
+  FRUSTUM_TOP,
+  FRUSTUM_NEAR,
+  FRUSTUM_FAR,
+
+  FRUSTUM_PLANE_COUNT,
+} frustum_plane_t;
+
+typedef struct {
+  vec4 planes[FRUSTUM_PLANE_COUNT]; // xyz normal pointing inwards, w distance
+} frustum_t;
+
+// bounding spheres in SoA layout, so the tests run 4 or 8 lanes at a time
+typedef struct {
+  DYNLIST(f32) x;
+  DYNLIST(f32) y;
+  DYNLIST(f32) z;
+  DYNLIST(f32) radius;
+  DYNLIST(u8) visible; // written by cull_batch_run, 1 if inside the frustum
+} cull_batch_t;
+
+// clip = view_proj * world, in either matrix layout
+void frustum_extract(frustum_t* frustum, mat4x4 view_proj);
+
+void cull_batch_init(cull_batch_t* batch);
+void cull_batch_destroy(cull_batch_t* batch);
+void cull_batch_resize(cull_batch_t* batch, u32 n);
+// tests the spheres in [begin, end), ranges that don't overlap can run on
+// separate threads
+u32 cull_batch_run(cull_batch_t* batch, const frustum_t* frustum, u32 begin,
+                   u32 end);
@@ -1,7 +1,26 @@
 #include "font.h"
 
+#include "c-lib/dynlist.h"
 #include "c-lib/misc.h"
-#include "render.h"
+#include "sprite_batch.h"
+
+#define FONT_LAYOUT_CACHE_SIZE 64 // direct mapped, a collision replaces
+
+typedef struct {
+  vec2 offset; // glyph center relative to the position of the string
+  vec4 uv;
+} glyph_quad_t;
+
+typedef struct {
+  u64 hash;
+  char* str;
+  vec2 size;
+  DYNLIST(glyph_quad_t) quads;
+} text_layout_t;
+
+static const sprite_sheet_t* font_sheet;
+static vec4 glyph_uvs[256]; // every byte maps to a cell, unknown ones to '?'
+static text_layout_t layout_cache[FONT_LAYOUT_CACHE_SIZE];
 
 static iv2 find_char(char ch) {
   static const char* lines[] = {
@@ -19,30 +38,95 @@ static iv2 find_char(char ch) {
       ++p;
     }
   }
-  return find_char('?');
+  return (iv2){-1, -1};
+}
+
+void font_init(const sprite_sheet_t* sheet) {
+  font_sheet = sheet;
+
+  iv2 unknown = find_char('?');
+  for (u32 ch = 0; ch < 256; ++ch) {
+    iv2 cell = find_char((char)ch);
+    if (cell.x < 0) cell = unknown;
+    sprite_sheet_tex_coords(glyph_uvs[ch], sheet, cell.y, cell.x);
+  }
+  LOG("Font glyph table built");
+}
+
+void font_destroy(void) {
+  for (u32 i = 0; i < FONT_LAYOUT_CACHE_SIZE; ++i) {
+    text_layout_t* layout = &layout_cache[i];
+    free(layout->str);
+    if (layout->quads) dynlist_destroy(layout->quads);
+    *layout = (text_layout_t){0};
+  }
 }
 
 void font_render_char(char ch, vec2 position, vec2 size, vec4 color) {
-  iv2 tex_idx = find_char(ch);
-  render_sprite_frame(tex_idx.y, tex_idx.x, position, size, color, false);
+  ASSERT(font_sheet);
+  const material_t* material = get_material(font_sheet->material);
+  sprite_batch_push(get_texture(material->texture)->id, material->sampler,
+                    position, size, glyph_uvs[(u8)ch], color);
 }
 
-void font_render_str(const char* str, vec2 position, vec2 size, vec4 color) {
-  ASSERT(size);
-  // if (size == NULL) {
-  // size = (vec2){font_sheet->cell_width, font_sheet->cell_height};
-  // }
-
-  f32 starting_x = position[0];
-  const char* p = str;
-  while (*p) {
+static u64 hash_str(const char* str) {
+  u64 hash = 14695981039346656037ull; // fnv-1a
+  for (const char* p = str; *p; ++p) {
+    hash ^= (u8)*p;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static void build_layout(text_layout_t* layout, const char* str, u64 hash,
+                         vec2 const size) {
+  free(layout->str);
+  layout->str = strdup(str);
+  ASSERT(layout->str);
+  layout->hash = hash;
+  vec2_mov(layout->size, size);
+  if (layout->quads) {
+    dynlist_resize_no_contract(layout->quads, 0);
+  } else {
+    layout->quads = dynlist_create(glyph_quad_t, 32);
+  }
+
+  vec2 pen = {0.0f, 0.0f};
+  for (const char* p = str; *p; ++p) {
     if (*p == '\n') {
-      position[1] -= size[1];
-      position[0] = starting_x;
-    } else {
-      font_render_char(*p, position, size, color);
-      position[0] += size[0];
+      pen[0] = 0.0f;
+      pen[1] -= size[1];
+      continue;
     }
-    ++p;
+    glyph_quad_t* quad = dynlist_push(layout->quads);
+    vec2_mov(quad->offset, pen);
+    vec4_mov(quad->uv, glyph_uvs[(u8)*p]);
+    pen[0] += size[0];
+  }
+}
+
+// strings are laid out once and replayed from the cache on later frames
+static text_layout_t* get_layout(const char* str, vec2 const size) {
+  u64 hash = hash_str(str);
+  text_layout_t* layout = &layout_cache[hash % FONT_LAYOUT_CACHE_SIZE];
+  bool hit = layout->str && layout->hash == hash &&
+             memcmp(layout->size, size, sizeof(vec2)) == 0 &&
+             strcmp(layout->str, str) == 0;
+  if (!hit) build_layout(layout, str, hash, size);
+  return layout;
+}
+
+void font_render_str(const char* str, vec2 position, vec2 size, vec4 color) {
+  ASSERT(size && font_sheet);
+
+  // the sheet material is resolved once per string, not per glyph
+  const material_t* material = get_material(font_sheet->material);
+  u32 texture = get_texture(material->texture)->id;
+  text_layout_t* layout = get_layout(str, size);
+  dynlist_each(layout->quads, quad) {
+    vec2 glyph_position;
+    vec2_add(glyph_position, position, quad->offset);
+    sprite_batch_push(texture, material->sampler, glyph_position, size,
+                      quad->uv, color);
   }
 }
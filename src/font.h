@@ -1,6 +1,10 @@
 #pragma once
 
 #include "c-lib/math.h"
+#include "render.h"
+
+void font_init(const sprite_sheet_t* sheet);
+void font_destroy(void);
 
 void font_render_char(char ch, vec2 position, vec2 size, vec4 color);
 void font_render_str(const char* str, vec2 position, vec2 size, vec4 color);
@@ -0,0 +1,215 @@
+#include "gl_state.h"
+
+#include "c-lib/misc.h"
+
+#define MAX_SAMPLERS 8
+#define UNKNOWN 0xFFFFFFFF // forces the next call through to the driver
+
+typedef struct {
+  GLenum min_filter, mag_filter, wrap;
+  u32 id;
+} sampler_entry_t;
+
+typedef struct {
+  u32 buffer;
+  size_t offset, size;
+} buffer_range_t;
+
+typedef struct {
+  u32 program;
+  u32 vao;
+  u32 array_buffer;
+  u32 uniform_buffer;
+  buffer_range_t uniform_ranges[GL_STATE_UNIFORM_BINDINGS];
+  u32 active_unit;
+  u32 textures[GL_STATE_TEXTURE_UNITS];
+  u32 samplers[GL_STATE_TEXTURE_UNITS];
+  u32 depth_test, blend; // bools, or UNKNOWN
+
+  sampler_entry_t sampler_cache[MAX_SAMPLERS];
+  u32 sampler_count;
+
+  gl_state_stats_t stats;
+} gl_state_t;
+
+static gl_state_t gls;
+
+// true if the call must be issued, updating the cached value
+static bool changed(u32* cached, u32 value) {
+  if (*cached == value) {
+    ++gls.stats.skipped;
+    return false;
+  }
+  *cached = value;
+  ++gls.stats.issued;
+  return true;
+}
+
+static void set_active_unit(u32 unit) {
+  if (changed(&gls.active_unit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void gl_state_init(void) {
+  gls.sampler_count = 0;
+  gl_state_invalidate();
+  LOG("GL state cache initialized");
+}
+
+// must be called after any GL state is changed outside of this module
+void gl_state_invalidate(void) {
+  gls.program = UNKNOWN;
+  gls.vao = UNKNOWN;
+  gls.array_buffer = UNKNOWN;
+  gls.uniform_buffer = UNKNOWN;
+  gls.active_unit = UNKNOWN;
+  for (u32 i = 0; i < GL_STATE_UNIFORM_BINDINGS; ++i) {
+    gls.uniform_ranges[i].buffer = UNKNOWN;
+  }
+  for (u32 i = 0; i < GL_STATE_TEXTURE_UNITS; ++i) {
+    gls.textures[i] = UNKNOWN;
+    gls.samplers[i] = UNKNOWN;
+  }
+  gls.depth_test = UNKNOWN;
+  gls.blend = UNKNOWN;
+}
+
+void gl_state_destroy(void) {
+  for (u32 i = 0; i < gls.sampler_count; ++i) {
+    glDeleteSamplers(1, &gls.sampler_cache[i].id);
+  }
+  gls.sampler_count = 0;
+  gl_state_invalidate();
+}
+
+void gl_state_frame_reset(void) { gls.stats = (gl_state_stats_t){0}; }
+
+gl_state_stats_t* gl_state_get_stats(void) { return &gls.stats; }
+
+void gl_state_use_program(u32 program) {
+  if (changed(&gls.program, program)) glUseProgram(program);
+}
+
+void gl_state_bind_vertex_array(u32 vao) {
+  if (changed(&gls.vao, vao)) glBindVertexArray(vao);
+}
+
+void gl_state_bind_buffer(GLenum target, u32 buffer) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      if (changed(&gls.array_buffer, buffer)) glBindBuffer(target, buffer);
+      break;
+    case GL_UNIFORM_BUFFER:
+      if (changed(&gls.uniform_buffer, buffer)) glBindBuffer(target, buffer);
+      break;
+    default:
+      // element array bindings live in the vao, so they are not tracked
+      ++gls.stats.issued;
+      glBindBuffer(target, buffer);
+      break;
+  }
+}
+
+void gl_state_bind_uniform_range(u32 index, u32 buffer, size_t offset,
+                                 size_t size) {
+  ASSERT(index < GL_STATE_UNIFORM_BINDINGS);
+  buffer_range_t* range = &gls.uniform_ranges[index];
+  if (range->buffer == buffer && range->offset == offset &&
+      range->size == size) {
+    ++gls.stats.skipped;
+    return;
+  }
+  *range = (buffer_range_t){.buffer = buffer, .offset = offset, .size = size};
+  ++gls.stats.issued;
+  glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+  gls.uniform_buffer = buffer; // also sets the generic binding
+}
+
+void gl_state_bind_texture(u32 unit, u32 texture) {
+  ASSERT(unit < GL_STATE_TEXTURE_UNITS);
+  if (gls.textures[unit] == texture) {
+    ++gls.stats.skipped;
+    return;
+  }
+  set_active_unit(unit);
+  changed(&gls.textures[unit], texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void gl_state_bind_sampler(u32 unit, u32 sampler) {
+  ASSERT(unit < GL_STATE_TEXTURE_UNITS);
+  if (changed(&gls.samplers[unit], sampler)) glBindSampler(unit, sampler);
+}
+
+void gl_state_set_depth_test(bool enabled) {
+  if (!changed(&gls.depth_test, enabled)) return;
+  if (enabled) {
+    glEnable(GL_DEPTH_TEST);
+  } else {
+    glDisable(GL_DEPTH_TEST);
+  }
+}
+
+void gl_state_set_blend(bool enabled) {
+  if (!changed(&gls.blend, enabled)) return;
+  if (enabled) {
+    glEnable(GL_BLEND);
+  } else {
+    glDisable(GL_BLEND);
+  }
+}
+
+void gl_state_delete_program(u32 program) {
+  // a program in use is only flagged for deletion, the binding stays
+  glDeleteProgram(program);
+}
+
+void gl_state_delete_vertex_array(u32 vao) {
+  if (gls.vao == vao) gls.vao = 0;
+  glDeleteVertexArrays(1, &vao);
+}
+
+void gl_state_delete_buffer(u32 buffer) {
+  if (gls.array_buffer == buffer) gls.array_buffer = 0;
+  if (gls.uniform_buffer == buffer) gls.uniform_buffer = 0;
+  for (u32 i = 0; i < GL_STATE_UNIFORM_BINDINGS; ++i) {
+    if (gls.uniform_ranges[i].buffer == buffer) {
+      gls.uniform_ranges[i].buffer = UNKNOWN;
+    }
+  }
+  glDeleteBuffers(1, &buffer);
+}
+
+void gl_state_delete_texture(u32 texture) {
+  for (u32 i = 0; i < GL_STATE_TEXTURE_UNITS; ++i) {
+    if (gls.textures[i] == texture) gls.textures[i] = 0;
+  }
+  glDeleteTextures(1, &texture);
+}
+
+// sampler objects override the texture's own filtering, so textures are never
+// mutated per draw. created once per unique filter/wrap combination.
+u32 gl_state_sampler(GLenum min_filter, GLenum mag_filter, GLenum wrap) {
+  for (u32 i = 0; i < gls.sampler_count; ++i) {
+    const sampler_entry_t* e = &gls.sampler_cache[i];
+    if (e->min_filter == min_filter && e->mag_filter == mag_filter &&
+        e->wrap == wrap) {
+      return e->id;
+    }
+  }
+
+  ASSERT(gls.sampler_count < MAX_SAMPLERS, "too many unique samplers");
+  u32 id;
+  glGenSamplers(1, &id);
+  glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, min_filter);
+  glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, mag_filter);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_S, wrap);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_T, wrap);
+
+  gls.sampler_cache[gls.sampler_count++] = (sampler_entry_t){
+      .min_filter = min_filter,
+      .mag_filter = mag_filter,
+      .wrap = wrap,
+      .id = id,
+  };
+  return id;
+}
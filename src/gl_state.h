@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "c-lib/types.h"
+
+#define GL_STATE_TEXTURE_UNITS 8
+#define GL_STATE_UNIFORM_BINDINGS 4
+
+typedef struct {
+  u32 issued;  // calls that reached the driver this frame
+  u32 skipped; // calls dropped because the state was already set
+} gl_state_stats_t;
+
+void gl_state_init(void);
+void gl_state_invalidate(void);
+void gl_state_destroy(void);
+void gl_state_frame_reset(void);
+gl_state_stats_t* gl_state_get_stats(void);
+
+void gl_state_use_program(u32 program);
+void gl_state_bind_vertex_array(u32 vao);
+void gl_state_bind_buffer(GLenum target, u32 buffer);
+void gl_state_bind_uniform_range(u32 index, u32 buffer, size_t offset,
+                                 size_t size);
+void gl_state_bind_texture(u32 unit, u32 texture);
+void gl_state_bind_sampler(u32 unit, u32 sampler);
+void gl_state_set_depth_test(bool enabled);
+void gl_state_set_blend(bool enabled);
+
+// deleting a bound object resets its binding to 0, so deletes go through here
+void gl_state_delete_program(u32 program);
+void gl_state_delete_vertex_array(u32 vao);
+void gl_state_delete_buffer(u32 buffer);
+void gl_state_delete_texture(u32 texture);
+
+u32 gl_state_sampler(GLenum min_filter, GLenum mag_filter, GLenum wrap);
@@ -0,0 +1,224 @@
+#include "headless.h"
+
+#include <glad/glad.h>
+
+#include "c-lib/misc.h"
+#include "file_io.h"
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+#endif
+
+static struct {
+  u32 width, height;
+  u32 fbo, color_rb, depth_rb;
+#ifdef __linux__
+  EGLDisplay display;
+  EGLContext context;
+  EGLSurface surface; // only when surfaceless contexts are not supported
+#else
+  GLFWwindow* window;
+#endif
+} headless;
+
+#ifdef __linux__
+static bool has_extension(const char* extensions, const char* name) {
+  size_t len = strlen(name);
+  for (const char* p = extensions; p && (p = strstr(p, name)); p += len) {
+    if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || !p[len])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static EGLDisplay get_display(void) {
+  // mesa can run with no window system at all, otherwise use the default
+  const char* client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (has_extension(client, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+            "eglGetPlatformDisplayEXT");
+    if (get_platform_display) {
+      return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                  EGL_DEFAULT_DISPLAY, NULL);
+    }
+  }
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static void init_context(void) {
+  headless.display = get_display();
+  EGLint major, minor;
+  if (headless.display == EGL_NO_DISPLAY ||
+      !eglInitialize(headless.display, &major, &minor)) {
+    ERROR_EXIT("failed to initialize egl\n");
+  }
+
+  const EGLint config_attribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE,
+  };
+  EGLConfig config;
+  EGLint config_count;
+  if (!eglChooseConfig(headless.display, config_attribs, &config, 1,
+                       &config_count) ||
+      config_count == 0) {
+    ERROR_EXIT("no egl config for desktop opengl\n");
+  }
+
+  eglBindAPI(EGL_OPENGL_API);
+  const EGLint context_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE,
+  };
+  headless.context = eglCreateContext(headless.display, config,
+                                      EGL_NO_CONTEXT, context_attribs);
+  if (headless.context == EGL_NO_CONTEXT) {
+    ERROR_EXIT("failed to create egl context\n");
+  }
+
+  // the fbo is the real target, a pbuffer is only made if egl insists on one
+  headless.surface = EGL_NO_SURFACE;
+  const char* extensions = eglQueryString(headless.display, EGL_EXTENSIONS);
+  if (!has_extension(extensions, "EGL_KHR_surfaceless_context")) {
+    const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    headless.surface =
+        eglCreatePbufferSurface(headless.display, config, pbuffer_attribs);
+  }
+  if (!eglMakeCurrent(headless.display, headless.surface, headless.surface,
+                      headless.context)) {
+    ERROR_EXIT("failed to make the egl context current\n");
+  }
+
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    ERROR_EXIT("failed to initialize glad");
+  }
+  LOG("Headless egl %d.%d context: %s", major, minor,
+      (const char*)glGetString(GL_RENDERER));
+}
+
+static void destroy_context(void) {
+  eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                 EGL_NO_CONTEXT);
+  if (headless.surface != EGL_NO_SURFACE) {
+    eglDestroySurface(headless.display, headless.surface);
+  }
+  eglDestroyContext(headless.display, headless.context);
+  eglTerminate(headless.display);
+}
+
+void headless_bind_context(bool current) {
+  bool ok = current ? eglMakeCurrent(headless.display, headless.surface,
+                                     headless.surface, headless.context)
+                    : eglMakeCurrent(headless.display, EGL_NO_SURFACE,
+                                     EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (!ok) {
+    ERROR_EXIT("failed to switch the egl context\n");
+  }
+}
+#else
+static void init_context(void) {
+  ASSERT(glfwInit());
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  headless.window = glfwCreateWindow(1, 1, "headless", NULL, NULL);
+  if (!headless.window) {
+    glfwTerminate();
+    ERROR_EXIT("failed to create hidden glfw window");
+  }
+  glfwMakeContextCurrent(headless.window);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    ERROR_EXIT("failed to initialize glad");
+  }
+}
+
+static void destroy_context(void) {
+  glfwDestroyWindow(headless.window);
+  glfwTerminate();
+}
+
+void headless_bind_context(bool current) {
+  glfwMakeContextCurrent(current ? headless.window : NULL);
+}
+#endif
+
+void headless_init(u32 width, u32 height) {
+  headless.width = width;
+  headless.height = height;
+  init_context();
+
+  glGenRenderbuffers(1, &headless.color_rb);
+  glBindRenderbuffer(GL_RENDERBUFFER, headless.color_rb);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenRenderbuffers(1, &headless.depth_rb);
+  glBindRenderbuffer(GL_RENDERBUFFER, headless.depth_rb);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  // stays bound for the whole run, nothing else draws to another target
+  glGenFramebuffers(1, &headless.fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, headless.fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, headless.color_rb);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, headless.depth_rb);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    ERROR_EXIT("headless framebuffer is incomplete\n");
+  }
+  LOG("Headless framebuffer %ux%u", width, height);
+}
+
+void headless_destroy(void) {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &headless.fbo);
+  glDeleteRenderbuffers(1, &headless.color_rb);
+  glDeleteRenderbuffers(1, &headless.depth_rb);
+  destroy_context();
+}
+
+bool headless_write_ppm(const char* path) {
+  char header[32];
+  const u32 w = headless.width, h = headless.height, row = w * 3;
+  const int header_len = snprintf(header, sizeof(header), "P6\n%u %u\n255\n",
+                                  w, h);
+  const size_t size = header_len + (size_t)row * h;
+  u8* data = malloc(size);
+  ASSERT(data);
+  memcpy(data, header, header_len);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  u8* pixels = data + header_len;
+  glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+
+  // gl rows start at the bottom, ppm rows at the top
+  u8* tmp = malloc(row);
+  ASSERT(tmp);
+  for (u32 y = 0; y < h / 2; ++y) {
+    u8* a = pixels + (size_t)y * row;
+    u8* b = pixels + (size_t)(h - 1 - y) * row;
+    memcpy(tmp, a, row);
+    memcpy(a, b, row);
+    memcpy(b, tmp, row);
+  }
+  free(tmp);
+
+  bool ok = io_file_write(data, size, path) == 0;
+  free(data);
+  return ok;
+}
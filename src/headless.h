@@ -0,0 +1,15 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// an offscreen context with no window or input, everything is drawn into a
+// framebuffer object of the requested size. linux uses egl (surfaceless or a
+// pbuffer, so mesa's llvmpipe works with no display or gpu), other platforms
+// fall back to a hidden glfw window
+void headless_init(u32 width, u32 height);
+void headless_destroy(void);
+// makes the context current on the calling thread, or releases it
+void headless_bind_context(bool current);
+
+// blocks until the frame is done, then writes it as a binary ppm
+bool headless_write_ppm(const char* path);
@@ -1,31 +1,166 @@
 #include "c-lib/misc.h"
+// before jobs.h, whose implementation includes profile.h
+#define CLIB_PROFILE_IMPL
+#include "c-lib/profile.h"
+#define CLIB_JOBS_IMPL
+#include "c-lib/jobs.h"
+#include "c-lib/time.h"
 #include "font.h"
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "bench.h"
+#include "math_bench.h"
+#include "math_test.h"
+#include "pass_timer.h"
 #include "render.h"
 #include "state.h"
 
+#define PROFILE_KEY_FRAMES 120 // captured when the profile key is pressed
+
 state_t state;
+static bool show_debug; // toggled with the debug key
 
-static void input_handle(float delta_time) {
-  camera_t* camera = get_camera();
-  vec3* light = get_light_pos();
-  const float camera_speed = 10.0f * delta_time;
+typedef struct {
+  bool headless;
+  u32 frames; // 0 runs until the window is closed
+  u32 width, height;
+  const char* dump_path; // ppm of the last frame, headless only
+  bool bench;
+  bench_options_t bench_options;
+  bool bench_math; // fast math kernels against libm, then exits
+  bool test_math;  // simd math against the _ref versions, then exits
+  u32 profile_frames; // captured from startup, 0 for none
+  const char* profile_path;
+  u32 jobs; // job workers including the main thread, 0 for one per core
+} options_t;
+
+static void usage(const char* program) {
+  ERROR_EXIT("usage: %s [--headless] [--frames N] [--size WxH] "
+             "[--dump out.ppm]\n"
+             "       [--bench] [--warmup N] [--cubes N] [--spheres N] "
+             "[--text N] [--out bench.json]\n"
+             "       [--bench-math] [--test-math]\n"
+             "       [--profile N] [--profile-out profile.json] "
+             "[--jobs N]\n",
+             program);
+}
+
+static options_t parse_args(int argc, char** argv) {
+  options_t options = {
+      .width = 1650,
+      .height = 1000,
+      .bench_options = {.warmup = 60, .out_path = "bench.json"},
+      .profile_path = "profile.json",
+  };
+  const struct {
+    const char* flag;
+    u32* value;
+  } counts[] = {
+      {"--frames", &options.frames},
+      {"--warmup", &options.bench_options.warmup},
+      {"--cubes", &options.bench_options.cubes},
+      {"--spheres", &options.bench_options.spheres},
+      {"--text", &options.bench_options.text_lines},
+      {"--profile", &options.profile_frames},
+      {"--jobs", &options.jobs},
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    bool is_count = false;
+    for (u32 j = 0; j < ARRLEN(counts) && value; ++j) {
+      if (strcmp(arg, counts[j].flag) != 0) continue;
+      *counts[j].value = (u32)strtoul(value, NULL, 10);
+      is_count = true;
+      ++i;
+    }
+
+    if (is_count) {
+      continue;
+    } else if (strcmp(arg, "--headless") == 0) {
+      options.headless = true;
+    } else if (strcmp(arg, "--bench") == 0) {
+      options.bench = true;
+    } else if (strcmp(arg, "--bench-math") == 0) {
+      options.bench_math = true;
+    } else if (strcmp(arg, "--test-math") == 0) {
+      options.test_math = true;
+    } else if (strcmp(arg, "--out") == 0 && value) {
+      options.bench_options.out_path = value;
+      ++i;
+    } else if (strcmp(arg, "--size") == 0 && value) {
+      if (sscanf(value, "%ux%u", &options.width, &options.height) != 2) {
+        usage(argv[0]);
+      }
+      ++i;
+    } else if (strcmp(arg, "--dump") == 0 && value) {
+      options.dump_path = value;
+      ++i;
+    } else if (strcmp(arg, "--profile-out") == 0 && value) {
+      options.profile_path = value;
+      ++i;
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if (options.bench) {
+    if (options.frames == 0) options.frames = 600;
+    options.bench_options.frames = options.frames;
+    options.bench_options.dump_path = options.dump_path;
+  }
+
+  // there is no window to close, so a headless run always has an end
+  if (options.headless && options.frames == 0) options.frames = 1;
+  if (options.dump_path && !options.headless) {
+    ERROR_EXIT("--dump is only supported with --headless\n");
+  }
+#ifndef CLIB_PROFILE
+  if (options.profile_frames) {
+    WARN("built without CLIB_PROFILE, rebuild with PROFILE=1 to capture");
+  }
+#endif
+  return options;
+}
+
+static bool should_quit(const options_t* options, u32 frame) {
+  if (options->frames && frame >= options->frames) return true;
+  return state.window && glfwWindowShouldClose(state.window);
+}
 
+// once per frame, so a press is seen exactly once however many steps run
+static void input_handle(const options_t* options) {
   if (state.input.states[INPUT_KEY_ESCAPE]) {
     glfwSetWindowShouldClose(state.window, true);
   }
+  if (state.input.states[INPUT_KEY_DEBUG] == KS_PRESSED) {
+    show_debug = !show_debug;
+  }
+  if (state.input.states[INPUT_KEY_PROFILE] == KS_PRESSED) {
+    PROFILE_CAPTURE(PROFILE_KEY_FRAMES, options->profile_path);
+  }
+}
 
-  vec3 camera_front;
-  get_camera_front(camera_front);
+// once per simulation step, held keys move the camera and the light
+static void input_simulate(f32 step) {
+  camera_t* camera = get_camera();
+  vec3* light = get_light_pos();
+  const float camera_speed = 10.0f * step;
 
-  vec3 up_dir = (vec3){0.0f, 1.0f, 0.0f};
-  vec3 right;
-  vec3_cross(right, camera_front, up_dir);
-  vec3_normalize(right, right);
+  // the basis is cached whenever the camera turns
+  const f32* camera_front = camera->front;
+  const f32* right = camera->right;
+
+  if (state.input.states[INPUT_KEY_W] || state.input.states[INPUT_KEY_S] ||
+      state.input.states[INPUT_KEY_A] || state.input.states[INPUT_KEY_D]) {
+    camera->dirty = true;
+  }
 
   vec3 move_vector;
   if (state.input.states[INPUT_KEY_W]) {
@@ -58,15 +193,78 @@ static void input_handle(float delta_time) {
   }
 }
 
-int main(void) {
-  state.window = render_init(1650, 1000);
+// frame rate, per pass timings and draw counts in the top left corner
+static void render_debug_overlay(void) {
+  static char text[512];
+  static u64 text_ns;
+
+  // refreshed a few times a second, so it stays readable and mostly cached
+  if (!text[0] || state.time.now_ns - text_ns >= 250000000ull) {
+    const pass_timings_t* timings = get_pass_timings();
+    const render_stats_t* stats = get_render_stats();
+    const gl_state_stats_t* gl_stats = get_gl_stats();
+    int len = snprintf(text, sizeof(text), "fps %u\npass      cpu ms  gpu ms\n",
+                       state.time.frame_rate);
+    for (u32 p = 0; p < PASS_TIMER_COUNT; ++p) {
+      len += snprintf(text + len, sizeof(text) - len, "%-8s %7.3f %7.3f\n",
+                      pass_timer_name(p), timings->cpu_ms[p],
+                      timings->gpu_ms[p]);
+    }
+    len += snprintf(text + len, sizeof(text) - len,
+                    "draws %u instanced %u\nvisible %u culled %u\n"
+                    "gl calls %u skipped %u",
+                    stats->draw_calls, stats->instanced_draw_calls,
+                    stats->visible, stats->culled, gl_stats->issued,
+                    gl_stats->skipped);
+    const time_pacer_t* pacer = &state.time.pacer;
+    if (pacer->period_ns) {
+      snprintf(text + len, sizeof(text) - len,
+               "\npacing us p50 %.0f p99 %.0f jitter p99 %.0f missed %u",
+               time_histogram_percentile(&pacer->overshoot, 50.0),
+               time_histogram_percentile(&pacer->overshoot, 99.0),
+               time_histogram_percentile(&pacer->jitter, 99.0),
+               pacer->missed);
+    }
+    text_ns = state.time.now_ns;
+  }
+
+  const iv2 size = get_window_size();
+  font_render_str(text, (vec2){20, size.y - 20}, (vec2){14, 14}, WHITE);
+}
+
+int main(int argc, char** argv) {
+  options_t options = parse_args(argc, argv);
+  if (options.bench_math) return math_bench_run() ? 0 : 1;
+  if (options.test_math) return math_test_run() ? 0 : 1;
+  PROFILE_THREAD_NAME("main");
+  PROFILE_CAPTURE(options.profile_frames, options.profile_path);
+  jobs_init(options.jobs);
+  state.window =
+      render_init(options.width, options.height, options.headless);
   config_init();
+  time_init(state.config.frame_rate, state.config.sim_rate);
+  // headless frames are a fixed 60hz apart, so --dump gives the same picture
+  // every run
+  if (options.headless) time_set_fixed_step(1000000000ull / 60);
 
-  while (!glfwWindowShouldClose(state.window)) {
-    time_update();
-    input_update();
+  if (options.bench) {
+    bool ok = bench_run(&options.bench_options);
+    render_destroy(state.window);
+    jobs_destroy();
+    return ok ? 0 : 1;
+  }
 
-    input_handle(state.time.delta);
+  for (u32 frame = 0; !should_quit(&options, frame); ++frame) {
+    time_update();
+    if (!options.headless) {
+      input_update();
+      input_handle(&options);
+    }
+    while (time_sim_step()) {
+      render_step(state.time.sim_time);
+      if (!options.headless) input_simulate(state.time.sim_step / 1000.0f);
+    }
+    render_update(state.time.alpha);
 
     render_begin();
     render_cube();
@@ -74,14 +272,21 @@ int main(void) {
     render_light();
     render_sphere();
     render_quad();
+    render_flush();
 
     font_render_str("abcdefghijklmnopqrstuvwxyz\nABCDEFGHIJKLMNOPQRSTUVWXYZ",
                     (vec2){50, 100}, (vec2){50, 50}, WHITE);
+    if (show_debug) render_debug_overlay();
+    if (options.dump_path && frame + 1 == options.frames) {
+      render_dump(options.dump_path);
+    }
     render_end();
 
     time_update_late();
+    PROFILE_FRAME();
   }
 
   render_destroy(state.window);
+  jobs_destroy();
   return 0;
 }
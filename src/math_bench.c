@@ -0,0 +1,329 @@
+#include "math_bench.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c-lib/log.h"
+#include "c-lib/math.h"
+#include "c-lib/misc.h"
+#include "c-lib/time.h"
+#include "transform_batch.h"
+
+#define MATH_BENCH_COUNT (1 << 16) // inputs per timed pass
+#define MATH_BENCH_REPS 64         // timed passes, the fastest is reported
+#define MATH_BENCH_SAMPLES (1 << 22) // per accuracy sweep
+
+// the documented bounds in c-lib/math.h
+#define SINCOS_MAX_ULP 2.0
+#define SINCOS_MAX_ABS 0x1p-23 // where the result is under 2^-9
+#define RSQRT_MAX_ULP 4.0
+#define ATAN2_MAX_ULP 3.0
+
+// a and b are the inputs, out0 and out1 the results
+typedef void (*math_kernel_t)(const f32* a, const f32* b, f32* out0,
+                              f32* out1, u32 n);
+
+typedef struct {
+  const char* name;
+  math_kernel_t run;
+} math_case_t;
+
+static struct {
+  f32* a;
+  f32* b;
+  f32* out0;
+  f32* out1;
+} bench;
+
+static void libm_sincos(const f32* a, const f32* b, f32* s, f32* c, u32 n) {
+  (void)b;
+  for (u32 i = 0; i < n; ++i) {
+    s[i] = sinf(a[i]);
+    c[i] = cosf(a[i]);
+  }
+}
+
+static void ref_sincos(const f32* a, const f32* b, f32* s, f32* c, u32 n) {
+  (void)b;
+  for (u32 i = 0; i < n; ++i) fast_sincosf_ref(a[i], &s[i], &c[i]);
+}
+
+static void scalar_sincos(const f32* a, const f32* b, f32* s, f32* c,
+                          u32 n) {
+  (void)b;
+  for (u32 i = 0; i < n; ++i) fast_sincosf(a[i], &s[i], &c[i]);
+}
+
+static void batch_sincos(const f32* a, const f32* b, f32* s, f32* c, u32 n) {
+  (void)b;
+  fast_sincos_n(s, c, a, n);
+}
+
+static void libm_rsqrt(const f32* a, const f32* b, f32* r, f32* unused,
+                       u32 n) {
+  (void)b, (void)unused;
+  for (u32 i = 0; i < n; ++i) r[i] = 1.0f / sqrtf(a[i]);
+}
+
+static void scalar_rsqrt(const f32* a, const f32* b, f32* r, f32* unused,
+                         u32 n) {
+  (void)b, (void)unused;
+  for (u32 i = 0; i < n; ++i) r[i] = fast_rsqrtf(a[i]);
+}
+
+static void libm_atan2(const f32* y, const f32* x, f32* r, f32* unused,
+                       u32 n) {
+  (void)unused;
+  for (u32 i = 0; i < n; ++i) r[i] = atan2f(y[i], x[i]);
+}
+
+static void ref_atan2(const f32* y, const f32* x, f32* r, f32* unused,
+                      u32 n) {
+  (void)unused;
+  for (u32 i = 0; i < n; ++i) r[i] = fast_atan2f_ref(y[i], x[i]);
+}
+
+static void scalar_atan2(const f32* y, const f32* x, f32* r, f32* unused,
+                         u32 n) {
+  (void)unused;
+  for (u32 i = 0; i < n; ++i) r[i] = fast_atan2f(y[i], x[i]);
+}
+
+#if MATH_SIMD
+// n is a multiple of 4 for every timed pass
+static void simd_rsqrt(const f32* a, const f32* b, f32* r, f32* unused,
+                       u32 n) {
+  (void)b, (void)unused;
+  for (u32 i = 0; i < n; i += 4) {
+    _mm_storeu_ps(r + i, fast_rsqrt4(_mm_loadu_ps(a + i)));
+  }
+}
+
+static void simd_atan2(const f32* y, const f32* x, f32* r, f32* unused,
+                       u32 n) {
+  (void)unused;
+  for (u32 i = 0; i < n; i += 4) {
+    _mm_storeu_ps(r + i,
+                  fast_atan2_4(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+  }
+}
+#endif
+
+static f32 random_range(f32 lo, f32 hi) {
+  return lo + (hi - lo) * ((f32)rand() / (f32)RAND_MAX);
+}
+
+// fastest pass, in ns per input
+static f64 time_kernel(math_kernel_t run) {
+  u64 best = UINT64_MAX;
+  for (u32 rep = 0; rep < MATH_BENCH_REPS; ++rep) {
+    const u64 start = time_ns();
+    run(bench.a, bench.b, bench.out0, bench.out1, MATH_BENCH_COUNT);
+    const u64 elapsed = time_ns() - start;
+    best = min(best, elapsed);
+  }
+  return (f64)best / MATH_BENCH_COUNT;
+}
+
+static void time_cases(const char* group, const math_case_t* cases, u32 n) {
+  for (u32 i = 0; i < n; ++i) {
+    LOG("Math bench: %-6s %-8s %7.3f ns", group, cases[i].name,
+        time_kernel(cases[i].run));
+  }
+}
+
+// model and normal matrices from random transforms on one core, in ns per
+// object
+static f64 time_transforms(void) {
+  transform_batch_t batch;
+  transform_batch_init(&batch);
+  transform_batch_resize(&batch, MATH_BENCH_COUNT);
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    vec3 axis = {random_range(-1.0f, 1.0f), random_range(-1.0f, 1.0f),
+                 random_range(-1.0f, 1.0f)};
+    vec3_normalize(axis, axis);
+    quat q;
+    quat_from_axis_angle(q, axis, random_range(-M_PI, M_PI));
+    batch.qx[i] = q[0];
+    batch.qy[i] = q[1];
+    batch.qz[i] = q[2];
+    batch.qw[i] = q[3];
+    batch.x[i] = random_range(-100.0f, 100.0f);
+    batch.y[i] = random_range(-100.0f, 100.0f);
+    batch.z[i] = random_range(-100.0f, 100.0f);
+    batch.sx[i] = random_range(0.1f, 4.0f);
+    batch.sy[i] = random_range(0.1f, 4.0f);
+    batch.sz[i] = random_range(0.1f, 4.0f);
+  }
+
+  u64 best = UINT64_MAX;
+  for (u32 rep = 0; rep < MATH_BENCH_REPS; ++rep) {
+    const u64 start = time_ns();
+    transform_batch_run(&batch, 0, MATH_BENCH_COUNT);
+    const u64 elapsed = time_ns() - start;
+    best = min(best, elapsed);
+  }
+  transform_batch_destroy(&batch);
+  return (f64)best / MATH_BENCH_COUNT;
+}
+
+// spacing of floats around the exact result v, rounded to float
+static f64 ulp_of(f64 v) {
+  int exponent;
+  frexp(fabs(v), &exponent);
+  return ldexp(1.0, max(exponent, -125) - 24);
+}
+
+static f64 ulp_error(f32 result, f64 exact) {
+  return fabs(result - exact) / ulp_of(exact);
+}
+
+// the sincos bound is in ulp, except near a zero where the range reduction's
+// absolute error is what is left
+static bool sincos_ok(f32 result, f64 exact, f64* worst_ulp, f64* worst_abs) {
+  const f64 error = fabs(result - exact);
+  *worst_abs = max(*worst_abs, error);
+  if (fabs(exact) < 0x1p-9) return error <= SINCOS_MAX_ABS;
+  const f64 ulps = ulp_error(result, exact);
+  *worst_ulp = max(*worst_ulp, ulps);
+  return ulps <= SINCOS_MAX_ULP;
+}
+
+// evenly spaced over the whole domain, through each of the versions
+static bool check_sincos(void) {
+  const math_kernel_t kernels[] = {ref_sincos, scalar_sincos, batch_sincos};
+  f64 worst_ulp = 0.0, worst_abs = 0.0;
+  bool ok = true;
+  for (u32 i = 0; i < MATH_BENCH_SAMPLES; i += MATH_BENCH_COUNT) {
+    for (u32 j = 0; j < MATH_BENCH_COUNT; ++j) {
+      const f64 t = (f64)(i + j) / MATH_BENCH_SAMPLES;
+      bench.a[j] = (f32)((2.0 * t - 1.0) * FAST_SINCOS_MAX);
+    }
+    for (u32 k = 0; k < ARRLEN(kernels); ++k) {
+      kernels[k](bench.a, NULL, bench.out0, bench.out1, MATH_BENCH_COUNT);
+      for (u32 j = 0; j < MATH_BENCH_COUNT; ++j) {
+        const f64 x = bench.a[j];
+        ok &= sincos_ok(bench.out0[j], sin(x), &worst_ulp, &worst_abs);
+        ok &= sincos_ok(bench.out1[j], cos(x), &worst_ulp, &worst_abs);
+      }
+    }
+  }
+  LOG("Math bench: sincos max %.2f ulp, %.3g absolute", worst_ulp, worst_abs);
+  return ok;
+}
+
+// every float in [1, 4), an estimate and its refinement only depend on the
+// mantissa and whether the exponent is odd
+static bool check_rsqrt(void) {
+  f64 worst = 0.0;
+  for (f32 x = 1.0f; x < 4.0f;) {
+    u32 n = 0;
+    for (; n < MATH_BENCH_COUNT && x < 4.0f; ++n, x = nextafterf(x, 4.0f)) {
+      bench.a[n] = x;
+    }
+    for (u32 j = 0; j < n; ++j) bench.out0[j] = fast_rsqrtf(bench.a[j]);
+#if MATH_SIMD
+    for (u32 j = 0; j + 4 <= n; j += 4) {
+      _mm_storeu_ps(bench.out1 + j, fast_rsqrt4(_mm_loadu_ps(bench.a + j)));
+    }
+    for (u32 j = n & ~3u; j < n; ++j) bench.out1[j] = bench.out0[j];
+#else
+    memcpy(bench.out1, bench.out0, n * sizeof(f32));
+#endif
+    for (u32 j = 0; j < n; ++j) {
+      const f64 exact = 1.0 / sqrt((f64)bench.a[j]);
+      worst = max(worst, ulp_error(bench.out0[j], exact));
+      worst = max(worst, ulp_error(bench.out1[j], exact));
+    }
+  }
+  LOG("Math bench: rsqrt  max %.2f ulp", worst);
+  return worst <= RSQRT_MAX_ULP;
+}
+
+// random directions over 40 binades, so every octant and both the small and
+// large ratios are covered
+static bool check_atan2(void) {
+  f64 worst = 0.0;
+  for (u32 i = 0; i < MATH_BENCH_SAMPLES; i += MATH_BENCH_COUNT) {
+    for (u32 j = 0; j < MATH_BENCH_COUNT; ++j) {
+      bench.a[j] = random_range(-1.0f, 1.0f) * ldexpf(1.0f, rand() % 40 - 20);
+      bench.b[j] = random_range(-1.0f, 1.0f) * ldexpf(1.0f, rand() % 40 - 20);
+    }
+    ref_atan2(bench.a, bench.b, bench.out0, NULL, MATH_BENCH_COUNT);
+    scalar_atan2(bench.a, bench.b, bench.out1, NULL, MATH_BENCH_COUNT);
+    for (u32 j = 0; j < MATH_BENCH_COUNT; ++j) {
+      const f64 exact = atan2((f64)bench.a[j], (f64)bench.b[j]);
+      worst = max(worst, ulp_error(bench.out0[j], exact));
+      worst = max(worst, ulp_error(bench.out1[j], exact));
+    }
+  }
+  LOG("Math bench: atan2  max %.2f ulp", worst);
+  return worst <= ATAN2_MAX_ULP &&
+         fpclassify(fast_atan2f(0.0f, 0.0f)) == FP_ZERO &&
+         fpclassify(fast_atan2f_ref(0.0f, 0.0f)) == FP_ZERO;
+}
+
+bool math_bench_run(void) {
+  bench.a = malloc(MATH_BENCH_COUNT * sizeof(f32));
+  bench.b = malloc(MATH_BENCH_COUNT * sizeof(f32));
+  bench.out0 = malloc(MATH_BENCH_COUNT * sizeof(f32));
+  bench.out1 = malloc(MATH_BENCH_COUNT * sizeof(f32));
+  ASSERT(bench.a && bench.b && bench.out0 && bench.out1);
+  LOG("Math bench: simd backend %d, %u inputs, best of %u", MATH_SIMD,
+      MATH_BENCH_COUNT, MATH_BENCH_REPS);
+
+  // angles a mesh or a camera would use
+  srand(1);
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    bench.a[i] = random_range(-2.0f * M_PI, 2.0f * M_PI);
+  }
+  const math_case_t sincos_cases[] = {
+      {"libm", libm_sincos},
+      {"ref", ref_sincos},
+      {"scalar", scalar_sincos},
+      {"batch", batch_sincos},
+  };
+  time_cases("sincos", sincos_cases, ARRLEN(sincos_cases));
+
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    bench.a[i] = random_range(1e-3f, 1e3f);
+  }
+  const math_case_t rsqrt_cases[] = {
+      {"libm", libm_rsqrt},
+      {"scalar", scalar_rsqrt},
+#if MATH_SIMD
+      {"simd", simd_rsqrt},
+#endif
+  };
+  time_cases("rsqrt", rsqrt_cases, ARRLEN(rsqrt_cases));
+
+  for (u32 i = 0; i < MATH_BENCH_COUNT; ++i) {
+    bench.a[i] = random_range(-1.0f, 1.0f);
+    bench.b[i] = random_range(-1.0f, 1.0f);
+  }
+  const math_case_t atan2_cases[] = {
+      {"libm", libm_atan2},
+      {"ref", ref_atan2},
+      {"scalar", scalar_atan2},
+#if MATH_SIMD
+      {"simd", simd_atan2},
+#endif
+  };
+  time_cases("atan2", atan2_cases, ARRLEN(atan2_cases));
+
+  const f64 transform_ns = time_transforms();
+  LOG("Math bench: %-15s %7.3f ns, %.1fM objects/s", "transform",
+      transform_ns, 1000.0 / transform_ns);
+
+  bool ok = check_sincos();
+  ok &= check_rsqrt();
+  ok &= check_atan2();
+  if (!ok) ERROR("Math bench: a kernel is outside its documented bound");
+
+  free(bench.a);
+  free(bench.b);
+  free(bench.out0);
+  free(bench.out1);
+  return ok;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// times the fast_ kernels of c-lib/math.h against libm and measures their
+// error over the documented domains, and times the transform batch kernel.
+// needs no window or gl context. returns false if a kernel is outside its
+// bound
+bool math_bench_run(void);
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// runs the mat4x4 functions of c-lib/math.h on the same inputs in both
+// storage layouts, for math_test.c. matrices go in and come out indexed
+// [row][column] whatever the layout, so the two results compare as is.
+//
+// the functions are the body below, compiled once by math_layout_column.c
+// and once by math_layout_row.c, which pick the layout and define
+// MATH_LAYOUT_IMPL and MATH_LAYOUT_RUN before including this
+typedef f32 math_layout_mat_t[4][4];
+
+typedef struct {
+  math_layout_mat_t a, b; // general matrices
+  f32 affine[3][4];
+  f32 v[4];
+  f32 eye[3], center[3], up[3];
+  f32 angle, x, y, z;
+} math_layout_input_t;
+
+// one result each, vectors fill the first row and the 3x3 normal matrix the
+// upper left
+enum {
+  MATH_LAYOUT_MUL,
+  MATH_LAYOUT_MUL_REF,
+  MATH_LAYOUT_MUL_VEC4,
+  MATH_LAYOUT_MUL_VEC4_REF,
+  MATH_LAYOUT_MUL_MAT3X4,
+  MATH_LAYOUT_MUL_MAT3X4_REF,
+  MATH_LAYOUT_TRANSLATE,
+  MATH_LAYOUT_ROTATE_X,
+  MATH_LAYOUT_ROTATE_Y,
+  MATH_LAYOUT_ROTATE_Z,
+  MATH_LAYOUT_SCALE_ANISO,
+  MATH_LAYOUT_TRANSPOSE,
+  MATH_LAYOUT_PERSPECTIVE,
+  MATH_LAYOUT_ORTHO,
+  MATH_LAYOUT_LOOK_AT,
+  MATH_LAYOUT_INVERT,
+  MATH_LAYOUT_INVERT_REF,
+  MATH_LAYOUT_NORMAL_MATRIX,
+  MATH_LAYOUT_RESULTS,
+};
+
+typedef math_layout_mat_t math_layout_results_t[MATH_LAYOUT_RESULTS];
+
+void math_layout_run_column_major(math_layout_results_t out,
+                                  const math_layout_input_t* in);
+void math_layout_run_row_major(math_layout_results_t out,
+                               const math_layout_input_t* in);
+
+#ifdef MATH_LAYOUT_IMPL
+#include <string.h>
+
+#include "c-lib/math.h"
+
+static void layout_load(mat4x4 M, math_layout_mat_t const in) {
+  for (u32 r = 0; r < 4; ++r) {
+    for (u32 c = 0; c < 4; ++c) M4(M, r, c) = in[r][c];
+  }
+}
+
+static void layout_store(math_layout_mat_t out, mat4x4 const M) {
+  for (u32 r = 0; r < 4; ++r) {
+    for (u32 c = 0; c < 4; ++c) out[r][c] = M4(M, r, c);
+  }
+}
+
+void MATH_LAYOUT_RUN(math_layout_results_t out,
+                     const math_layout_input_t* in) {
+  memset(out, 0, sizeof(math_layout_results_t));
+  mat4x4 a, b, M;
+  mat3x4 affine;
+  mat3x3 N;
+  vec4 v;
+  layout_load(a, in->a);
+  layout_load(b, in->b);
+  memcpy(affine, in->affine, sizeof(affine));
+
+  mat4x4_mul(M, a, b);
+  layout_store(out[MATH_LAYOUT_MUL], M);
+  mat4x4_mul_ref(M, a, b);
+  layout_store(out[MATH_LAYOUT_MUL_REF], M);
+  mat4x4_mul_vec4(v, a, in->v);
+  memcpy(out[MATH_LAYOUT_MUL_VEC4][0], v, sizeof(v));
+  mat4x4_mul_vec4_ref(v, a, in->v);
+  memcpy(out[MATH_LAYOUT_MUL_VEC4_REF][0], v, sizeof(v));
+  mat4x4_mul_mat3x4(M, a, affine);
+  layout_store(out[MATH_LAYOUT_MUL_MAT3X4], M);
+  mat4x4_mul_mat3x4_ref(M, a, affine);
+  layout_store(out[MATH_LAYOUT_MUL_MAT3X4_REF], M);
+
+  mat4x4_mov(M, a);
+  mat4x4_translate(M, in->x, in->y, in->z);
+  layout_store(out[MATH_LAYOUT_TRANSLATE], M);
+  mat4x4_rotate_x(M, a, in->angle);
+  layout_store(out[MATH_LAYOUT_ROTATE_X], M);
+  mat4x4_rotate_y(M, a, in->angle);
+  layout_store(out[MATH_LAYOUT_ROTATE_Y], M);
+  mat4x4_rotate_z(M, a, in->angle);
+  layout_store(out[MATH_LAYOUT_ROTATE_Z], M);
+  mat4x4_scale_aniso(M, a, in->x, in->y, in->z);
+  layout_store(out[MATH_LAYOUT_SCALE_ANISO], M);
+  mat4x4_transpose(M, a);
+  layout_store(out[MATH_LAYOUT_TRANSPOSE], M);
+
+  mat4x4_perspective(M, in->angle, in->x, in->y, in->z);
+  layout_store(out[MATH_LAYOUT_PERSPECTIVE], M);
+  mat4x4_ortho(M, -in->x, in->x, -in->y, in->y, in->angle, in->z);
+  layout_store(out[MATH_LAYOUT_ORTHO], M);
+  mat4x4_look_at(M, in->eye, in->center, in->up);
+  layout_store(out[MATH_LAYOUT_LOOK_AT], M);
+
+  mat4x4_invert(M, a);
+  layout_store(out[MATH_LAYOUT_INVERT], M);
+  mat4x4_invert_ref(M, a);
+  layout_store(out[MATH_LAYOUT_INVERT_REF], M);
+  mat4x4_normal_matrix(N, a);
+  for (u32 r = 0; r < 3; ++r) {
+    memcpy(out[MATH_LAYOUT_NORMAL_MATRIX][r], N[r], sizeof(N[r]));
+  }
+}
+#endif
@@ -0,0 +1,8 @@
+// the column major half of math_layout.h, whatever ROW_MAJOR the build uses.
+// multiply adds are never fused, the compiler would fuse each layout's code
+// in different places, which is outside what math.h keeps the same
+#pragma GCC optimize("fp-contract=off")
+#undef CLIB_MATH_ROW_MAJOR
+#define MATH_LAYOUT_IMPL
+#define MATH_LAYOUT_RUN math_layout_run_column_major
+#include "math_layout.h"
@@ -0,0 +1,10 @@
+// the row major half of math_layout.h, whatever ROW_MAJOR the build uses.
+// multiply adds are never fused, the compiler would fuse each layout's code
+// in different places, which is outside what math.h keeps the same
+#pragma GCC optimize("fp-contract=off")
+#ifndef CLIB_MATH_ROW_MAJOR
+#define CLIB_MATH_ROW_MAJOR
+#endif
+#define MATH_LAYOUT_IMPL
+#define MATH_LAYOUT_RUN math_layout_run_row_major
+#include "math_layout.h"
@@ -0,0 +1,541 @@
+#include "math_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c-lib/log.h"
+#include "c-lib/math.h"
+#include "c-lib/misc.h"
+#include "math_layout.h"
+#include "transform_batch.h"
+
+#define MATH_TEST_SAMPLES 200000 // random inputs per check
+
+// the bound in c-lib/math.h, in ulp of the magnitude of the summed terms,
+// 2n for products of at most n = 4 terms. sse2 adds in the order of the
+// scalar loops, so it matches them exactly
+#if MATH_SIMD == MATH_SIMD_NONE || MATH_SIMD == MATH_SIMD_SSE2
+#define SIMD_MAX_ULP 0.0
+#else
+#define SIMD_MAX_ULP 8.0
+#endif
+
+typedef struct {
+  const char* name;
+  f64 bound; // ulp
+  f64 worst; // ulp
+  u32 failures;
+} check_t;
+
+#define SIMD_CHECK(_name) {.name = (_name), .bound = SIMD_MAX_ULP}
+
+// inverses against f64, normwise, in units of 2^-24 times the condition
+// number. a stable inverse stays within about n of them
+#define INVERT_MAX_ERROR 4.0
+// the transform kernel's normals are products, not solves, so they get a
+// plain bound in ulp of their largest element
+#define KERNEL_NORMAL_MAX_ULP 8.0
+
+static f32 random_range(f32 lo, f32 hi) {
+  return lo + (hi - lo) * ((f32)rand() / (f32)RAND_MAX);
+}
+
+// signed, over 16 binades so sums cancel and magnitudes differ
+static f32 random_value(void) {
+  return random_range(-1.0f, 1.0f) * ldexpf(1.0f, rand() % 16 - 8);
+}
+
+static void random_vec(f32* v, u32 n) {
+  for (u32 i = 0; i < n; ++i) v[i] = random_value();
+}
+
+// spacing of floats at magnitude m
+static f64 ulp_of(f64 m) {
+  int exponent;
+  frexp(fabs(m), &exponent);
+  return ldexp(1.0, max(exponent, -125) - 24);
+}
+
+// an error already in the units of the check's bound
+static void check_error(check_t* c, f64 error) {
+  if (!(error <= c->bound)) ++c->failures;
+  if (error > c->worst || isnan(error)) c->worst = error;
+}
+
+// got against want, in ulp of the magnitude of the terms that were summed
+static void check(check_t* c, f32 got, f32 want, f64 magnitude) {
+  check_error(c, fabs((f64)got - (f64)want) / ulp_of(magnitude));
+}
+
+static bool report(const check_t* c) {
+  if (c->failures) {
+    ERROR("Math test: %-18s %u failures, worst %.2f, bound %.2f",
+          c->name, c->failures, c->worst, c->bound);
+    return false;
+  }
+  LOG("Math test: %-18s max %.2f, bound %.2f", c->name, c->worst, c->bound);
+  return true;
+}
+
+// elementwise results, each against the magnitude of its own terms
+static void check_n(check_t* c, const f32* got, const f32* want,
+                    const f64* magnitude, u32 n) {
+  for (u32 i = 0; i < n; ++i) check(c, got[i], want[i], magnitude[i]);
+}
+
+#define MATH_TEST_VEC(n) \
+static bool test_vec##n(void) { \
+  check_t add = SIMD_CHECK("vec" #n " add sub"); \
+  check_t scale = SIMD_CHECK("vec" #n " scale lerp"); \
+  check_t dot = SIMD_CHECK("vec" #n " dot"); \
+  check_t len = SIMD_CHECK("vec" #n " len"); \
+  check_t normalize = SIMD_CHECK("vec" #n " normalize"); \
+  for (u32 i = 0; i < MATH_TEST_SAMPLES; ++i) { \
+    vec##n a, b, r, want; \
+    f64 sum[n], scaled[n], lerped[n], unit[n], terms = 0.0; \
+    random_vec(a, n); \
+    random_vec(b, n); \
+    const f32 t = random_range(0.0f, 1.0f); \
+    for (u32 j = 0; j < n; ++j) { \
+      sum[j] = fabs(a[j]) + fabs(b[j]); \
+      scaled[j] = fabs(a[j] * t); \
+      lerped[j] = fabs(a[j]) + fabs((b[j] - a[j]) * t); \
+      unit[j] = 1.0; \
+      terms += fabs((f64)a[j] * b[j]); \
+    } \
+\
+    vec##n##_add(r, a, b); \
+    vec##n##_add_ref(want, a, b); \
+    check_n(&add, r, want, sum, n); \
+    vec##n##_sub(r, a, b); \
+    vec##n##_sub_ref(want, a, b); \
+    check_n(&add, r, want, sum, n); \
+    vec##n##_scale(r, a, t); \
+    vec##n##_scale_ref(want, a, t); \
+    check_n(&scale, r, want, scaled, n); \
+    vec##n##_lerp(r, a, b, t); \
+    vec##n##_lerp_ref(want, a, b, t); \
+    check_n(&scale, r, want, lerped, n); \
+\
+    check(&dot, vec##n##_dot(a, b), vec##n##_dot_ref(a, b), terms); \
+    check(&len, vec##n##_len(a), vec##n##_len_ref(a), vec##n##_len_ref(a)); \
+    vec##n##_normalize(r, a); \
+    vec##n##_normalize_ref(want, a); \
+    check_n(&normalize, r, want, unit, n); \
+  } \
+  bool ok = report(&add); \
+  ok &= report(&scale); \
+  ok &= report(&dot); \
+  ok &= report(&len); \
+  ok &= report(&normalize); \
+  return ok; \
+}
+
+MATH_TEST_VEC(3)
+MATH_TEST_VEC(4)
+
+static void random_mat4x4(mat4x4 M) {
+  for (u32 r = 0; r < 4; ++r) random_vec(M[r], 4);
+}
+
+static void random_mat3x4(mat3x4 M) {
+  for (u32 r = 0; r < 3; ++r) random_vec(M[r], 4);
+}
+
+// every element is a 4 term sum, read by row and column in either layout
+static bool test_matrices(void) {
+  check_t mul = SIMD_CHECK("mat4x4 mul");
+  check_t mul_vec4 = SIMD_CHECK("mat4x4 mul vec4");
+  check_t mul_affine = SIMD_CHECK("mat4x4 mul mat3x4");
+  check_t affine = SIMD_CHECK("mat3x4 mul");
+  for (u32 i = 0; i < MATH_TEST_SAMPLES / 4; ++i) {
+    mat4x4 a, b, M, want;
+    mat3x4 c, d, A, want_affine;
+    vec4 v, r, want_v;
+    random_mat4x4(a);
+    random_mat4x4(b);
+    random_mat3x4(c);
+    random_mat3x4(d);
+    random_vec(v, 4);
+
+    mat4x4_mul(M, a, b);
+    mat4x4_mul_ref(want, a, b);
+    for (u32 row = 0; row < 4; ++row) {
+      for (u32 col = 0; col < 4; ++col) {
+        f64 terms = 0.0;
+        for (u32 k = 0; k < 4; ++k) {
+          terms += fabs((f64)M4(a, row, k) * M4(b, k, col));
+        }
+        check(&mul, M4(M, row, col), M4(want, row, col), terms);
+      }
+    }
+
+    mat4x4_mul_vec4(r, a, v);
+    mat4x4_mul_vec4_ref(want_v, a, v);
+    for (u32 row = 0; row < 4; ++row) {
+      f64 terms = 0.0;
+      for (u32 k = 0; k < 4; ++k) terms += fabs((f64)M4(a, row, k) * v[k]);
+      check(&mul_vec4, r[row], want_v[row], terms);
+    }
+
+    // the implicit bottom row of the affine side is 0 0 0 1
+    mat4x4_mul_mat3x4(M, a, c);
+    mat4x4_mul_mat3x4_ref(want, a, c);
+    for (u32 row = 0; row < 4; ++row) {
+      for (u32 col = 0; col < 4; ++col) {
+        f64 terms = col == 3 ? fabs(M4(a, row, 3)) : 0.0;
+        for (u32 k = 0; k < 3; ++k) {
+          terms += fabs((f64)M4(a, row, k) * c[k][col]);
+        }
+        check(&mul_affine, M4(M, row, col), M4(want, row, col), terms);
+      }
+    }
+
+    mat3x4_mul(A, c, d);
+    mat3x4_mul_ref(want_affine, c, d);
+    for (u32 row = 0; row < 3; ++row) {
+      for (u32 col = 0; col < 4; ++col) {
+        f64 terms = col == 3 ? fabs(c[row][3]) : 0.0;
+        for (u32 k = 0; k < 3; ++k) terms += fabs((f64)c[row][k] * d[k][col]);
+        check(&affine, A[row][col], want_affine[row][col], terms);
+      }
+    }
+  }
+  bool ok = report(&mul);
+  ok &= report(&mul_vec4);
+  ok &= report(&mul_affine);
+  ok &= report(&affine);
+  return ok;
+}
+
+// gauss-jordan with partial pivoting on the n x n matrix a, false if it is
+// singular even in f64
+static bool invert_f64(u32 n, f64 inv[4][4], f64 const a[4][4]) {
+  f64 m[4][8];
+  for (u32 r = 0; r < n; ++r) {
+    for (u32 c = 0; c < n; ++c) {
+      m[r][c] = a[r][c];
+      m[r][n + c] = r == c ? 1.0 : 0.0;
+    }
+  }
+  for (u32 c = 0; c < n; ++c) {
+    u32 pivot = c;
+    for (u32 r = c + 1; r < n; ++r) {
+      if (fabs(m[r][c]) > fabs(m[pivot][c])) pivot = r;
+    }
+    if (fpclassify(m[pivot][c]) == FP_ZERO) return false;
+    for (u32 k = 0; k < 2 * n; ++k) {
+      const f64 t = m[c][k];
+      m[c][k] = m[pivot][k];
+      m[pivot][k] = t;
+    }
+    const f64 k_pivot = 1.0 / m[c][c];
+    for (u32 k = 0; k < 2 * n; ++k) m[c][k] *= k_pivot;
+    for (u32 r = 0; r < n; ++r) {
+      if (r == c) continue;
+      const f64 f = m[r][c];
+      for (u32 k = 0; k < 2 * n; ++k) m[r][k] -= f * m[c][k];
+    }
+  }
+  for (u32 r = 0; r < n; ++r) {
+    for (u32 c = 0; c < n; ++c) inv[r][c] = m[r][n + c];
+  }
+  return true;
+}
+
+// largest row sum
+static f64 norm_f64(u32 n, f64 const a[4][4]) {
+  f64 norm = 0.0;
+  for (u32 r = 0; r < n; ++r) {
+    f64 sum = 0.0;
+    for (u32 c = 0; c < n; ++c) sum += fabs(a[r][c]);
+    norm = max(norm, sum);
+  }
+  return norm;
+}
+
+// got against the f64 inverse of a, normwise and relative to how well a is
+// conditioned. transposed compares got to (a^-1)^T
+static void check_inverse(check_t* c, u32 n, f64 const got[4][4],
+                          f64 const a[4][4], f64 const inv[4][4],
+                          bool transposed) {
+  f64 diff[4][4];
+  for (u32 r = 0; r < n; ++r) {
+    for (u32 k = 0; k < n; ++k) {
+      diff[r][k] = got[r][k] - (transposed ? inv[k][r] : inv[r][k]);
+    }
+  }
+  const f64 inv_norm = norm_f64(n, inv);
+  const f64 condition = norm_f64(n, a) * inv_norm;
+  // the norm of the transpose is the largest column sum, at most n times
+  // the largest row sum
+  const f64 error = norm_f64(n, diff) / (n * inv_norm);
+  check_error(c, error / (0x1p-24 * condition));
+}
+
+static void random_quat(quat q) {
+  vec3 axis = {random_range(-1.0f, 1.0f), random_range(-1.0f, 1.0f),
+               random_range(-1.0f, 1.0f)};
+  vec3_normalize(axis, axis);
+  quat_from_axis_angle(q, axis, random_range(-M_PI, M_PI));
+}
+
+// T R S, with a scale of squash on a random axis, and mirrored at random
+static void random_affine(mat3x4 M, f32 squash) {
+  quat q;
+  random_quat(q);
+  vec3 scale = {random_range(0.25f, 4.0f), random_range(0.25f, 4.0f),
+                random_range(0.25f, 4.0f)};
+  scale[rand() % 3] *= squash;
+  if (rand() & 1) scale[rand() % 3] *= -1.0f;
+  quat_to_mat3x4(M, q);
+  mat3x4_scale_aniso(M, scale[0], scale[1], scale[2]);
+  for (u32 r = 0; r < 3; ++r) M[r][3] = random_range(-100.0f, 100.0f);
+}
+
+// perspective * view * model, or the model alone
+static void random_transform(mat4x4 M, f32 squash, bool projected) {
+  mat3x4 model;
+  random_affine(model, squash);
+  mat3x4_to_mat4x4(M, model);
+  if (!projected) return;
+
+  mat4x4 proj, view_proj;
+  mat3x4 view;
+  vec3 eye = {random_range(-20.0f, 20.0f), random_range(-20.0f, 20.0f),
+              random_range(-20.0f, 20.0f)};
+  vec3 up = {0.0f, 1.0f, 0.0f};
+  mat3x4_look_at(view, eye, (vec3){0.0f, 0.0f, 0.0f}, up);
+  mat4x4_perspective(proj, random_range(0.5f, 1.5f), 1.65f, 0.1f, 100.0f);
+  mat4x4_mul_mat3x4(view_proj, proj, view);
+  mat4x4_mul_mat3x4(M, view_proj, model);
+}
+
+static void mat4x4_to_f64(f64 out[4][4], mat4x4 const M) {
+  for (u32 r = 0; r < 4; ++r) {
+    for (u32 c = 0; c < 4; ++c) out[r][c] = M4(M, r, c);
+  }
+}
+
+static void mat3x4_to_f64(f64 out[4][4], mat3x4 const M) {
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) out[r][c] = M[r][c];
+  }
+}
+
+// general, well conditioned and close to singular inputs against f64.
+// exactly singular ones have to be refused
+static bool test_inverses(void) {
+  check_t invert = {.name = "mat4x4 invert", .bound = INVERT_MAX_ERROR};
+  check_t invert_ref = {.name = "mat4x4 invert ref",
+                        .bound = INVERT_MAX_ERROR};
+  check_t normal = {.name = "normal matrix", .bound = INVERT_MAX_ERROR};
+  u32 singular_accepted = 0;
+  const f32 squashes[] = {1.0f, 1e-3f, 1e-5f};
+  for (u32 i = 0; i < MATH_TEST_SAMPLES / 4; ++i) {
+    const f32 squash = squashes[i % ARRLEN(squashes)];
+    mat4x4 A, X;
+    f64 a[4][4], inv[4][4], got[4][4];
+    random_transform(A, squash, i & 1);
+    mat4x4_to_f64(a, A);
+    if (!invert_f64(4, inv, a)) continue;
+
+    if (mat4x4_invert(X, A)) {
+      mat4x4_to_f64(got, X);
+      check_inverse(&invert, 4, got, a, inv, false);
+    } else {
+      ++invert.failures;
+    }
+    if (mat4x4_invert_ref(X, A)) {
+      mat4x4_to_f64(got, X);
+      check_inverse(&invert_ref, 4, got, a, inv, false);
+    } else {
+      ++invert_ref.failures;
+    }
+
+    mat3x3 N;
+    f64 a3[4][4], inv3[4][4];
+    mat3x4 affine;
+    random_affine(affine, squash);
+    mat3x4_to_f64(a3, affine);
+    if (!invert_f64(3, inv3, a3)) continue;
+    if (mat3x4_normal_matrix(N, affine)) {
+      for (u32 r = 0; r < 3; ++r) {
+        for (u32 c = 0; c < 3; ++c) got[r][c] = N[r][c];
+      }
+      check_inverse(&normal, 3, got, a3, inv3, true);
+    } else {
+      ++normal.failures;
+    }
+
+    // a zero scale leaves the matrix exactly singular
+    random_transform(A, 0.0f, i & 1);
+    singular_accepted += mat4x4_invert(X, A) + mat4x4_invert_ref(X, A);
+    random_affine(affine, 0.0f);
+    singular_accepted += mat3x4_normal_matrix(N, affine);
+  }
+  bool ok = report(&invert);
+  ok &= report(&invert_ref);
+  ok &= report(&normal);
+  if (singular_accepted) {
+    ERROR("Math test: %u singular matrices were inverted", singular_accepted);
+    ok = false;
+  }
+  return ok;
+}
+
+// the kernel's cofactors against |det| (A^-1)^T of its own model in f64,
+// through both the simd lanes and the scalar tail. the scales go down to 0,
+// where the cofactors have to stay finite
+static bool test_kernel_normals(void) {
+  check_t normal = {.name = "kernel normals", .bound = KERNEL_NORMAL_MAX_ULP};
+  const f32 squashes[] = {1.0f, 1e-3f, 1e-6f, 0.0f};
+  transform_batch_t batch;
+  transform_batch_init(&batch);
+  const u32 n = 1023; // not a multiple of the lane count
+  transform_batch_resize(&batch, n);
+  for (u32 i = 0; i < n; ++i) {
+    quat q;
+    random_quat(q);
+    batch.qx[i] = q[0];
+    batch.qy[i] = q[1];
+    batch.qz[i] = q[2];
+    batch.qw[i] = q[3];
+    f32* scales[3] = {&batch.sx[i], &batch.sy[i], &batch.sz[i]};
+    for (u32 k = 0; k < 3; ++k) *scales[k] = random_range(0.25f, 4.0f);
+    *scales[rand() % 3] *= squashes[i % ARRLEN(squashes)];
+    if (rand() & 1) *scales[rand() % 3] *= -1.0f;
+    batch.x[i] = batch.y[i] = batch.z[i] = 0.0f;
+  }
+  transform_batch_run(&batch, 0, n);
+
+  for (u32 i = 0; i < n; ++i) {
+    // the rotation the f32 quaternion stands for, and the same scales, in
+    // f64. an f32 quaternion is off unit length by some e, which moves each
+    // element of the kernel's rotation up to 2e off it. that much error is
+    // the input's, and is not held against the kernel
+    const f64 length2 = (f64)batch.qx[i] * batch.qx[i] +
+                        (f64)batch.qy[i] * batch.qy[i] +
+                        (f64)batch.qz[i] * batch.qz[i] +
+                        (f64)batch.qw[i] * batch.qw[i];
+    const f64 k_len = 1.0 / sqrt(length2);
+    const f64 x = batch.qx[i] * k_len, y = batch.qy[i] * k_len;
+    const f64 z = batch.qz[i] * k_len, w = batch.qw[i] * k_len;
+    const f64 k[3] = {batch.sx[i], batch.sy[i], batch.sz[i]};
+    const f64 R[3][3] = {
+        {1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - w * z),
+         2.0 * (x * z + w * y)},
+        {2.0 * (x * y + w * z), 1.0 - 2.0 * (x * x + z * z),
+         2.0 * (y * z - w * x)},
+        {2.0 * (x * z - w * y), 2.0 * (y * z + w * x),
+         1.0 - 2.0 * (x * x + y * y)},
+    };
+    f64 A[3][3], C[3][3];
+    for (u32 r = 0; r < 3; ++r) {
+      for (u32 c = 0; c < 3; ++c) A[r][c] = R[r][c] * k[c];
+    }
+    // cofactors are the cross products of the other two rows
+    f64 largest = 0.0;
+    for (u32 r = 0; r < 3; ++r) {
+      const f64* a = A[(r + 1) % 3];
+      const f64* b = A[(r + 2) % 3];
+      C[r][0] = a[1] * b[2] - a[2] * b[1];
+      C[r][1] = a[2] * b[0] - a[0] * b[2];
+      C[r][2] = a[0] * b[1] - a[1] * b[0];
+    }
+    const f64 det = A[0][0] * C[0][0] + A[0][1] * C[0][1] + A[0][2] * C[0][2];
+    const f64 sign = signbit(k[0] * k[1] * k[2]) ? -1.0 : 1.0;
+    for (u32 r = 0; r < 3; ++r) {
+      for (u32 c = 0; c < 3; ++c) largest = max(largest, fabs(C[r][c]));
+    }
+    const f64 drift[3] = {
+        2.0 * fabs(length2 - 1.0) * fabs(k[1] * k[2]),
+        2.0 * fabs(length2 - 1.0) * fabs(k[0] * k[2]),
+        2.0 * fabs(length2 - 1.0) * fabs(k[0] * k[1]),
+    };
+    for (u32 r = 0; r < 3; ++r) {
+      for (u32 c = 0; c < 3; ++c) {
+        const f32 got = batch.normal[i][r][c];
+        if (!isfinite(got)) ++normal.failures;
+        const f64 error = fabs((f64)got - C[r][c] * sign) - drift[c];
+        check_error(&normal, max(error, 0.0) / ulp_of(largest));
+      }
+    }
+    // and the sign keeps them pointing out of mirrored objects
+    if (det * sign < 0.0) ++normal.failures;
+  }
+  transform_batch_destroy(&batch);
+  return report(&normal);
+}
+
+static const char* const layout_names[MATH_LAYOUT_RESULTS] = {
+    [MATH_LAYOUT_MUL] = "mat4x4 mul",
+    [MATH_LAYOUT_MUL_REF] = "mat4x4 mul ref",
+    [MATH_LAYOUT_MUL_VEC4] = "mat4x4 mul vec4",
+    [MATH_LAYOUT_MUL_VEC4_REF] = "mat4x4 mul vec4 ref",
+    [MATH_LAYOUT_MUL_MAT3X4] = "mat4x4 mul mat3x4",
+    [MATH_LAYOUT_MUL_MAT3X4_REF] = "mat4x4 mul mat3x4 ref",
+    [MATH_LAYOUT_TRANSLATE] = "mat4x4 translate",
+    [MATH_LAYOUT_ROTATE_X] = "mat4x4 rotate x",
+    [MATH_LAYOUT_ROTATE_Y] = "mat4x4 rotate y",
+    [MATH_LAYOUT_ROTATE_Z] = "mat4x4 rotate z",
+    [MATH_LAYOUT_SCALE_ANISO] = "mat4x4 scale aniso",
+    [MATH_LAYOUT_TRANSPOSE] = "mat4x4 transpose",
+    [MATH_LAYOUT_PERSPECTIVE] = "mat4x4 perspective",
+    [MATH_LAYOUT_ORTHO] = "mat4x4 ortho",
+    [MATH_LAYOUT_LOOK_AT] = "mat4x4 look at",
+    [MATH_LAYOUT_INVERT] = "mat4x4 invert",
+    [MATH_LAYOUT_INVERT_REF] = "mat4x4 invert ref",
+    [MATH_LAYOUT_NORMAL_MATRIX] = "mat4x4 normal matrix",
+};
+
+// math.h promises the same floats from both layouts, so they are compared
+// bit for bit
+static bool test_layouts(void) {
+  u32 mismatches[MATH_LAYOUT_RESULTS] = {0};
+  math_layout_results_t column, row;
+  for (u32 i = 0; i < MATH_TEST_SAMPLES / 100; ++i) {
+    math_layout_input_t in;
+    random_vec(&in.a[0][0], 16);
+    random_vec(&in.b[0][0], 16);
+    random_vec(&in.affine[0][0], 12);
+    random_vec(in.v, 4);
+    random_vec(in.eye, 3);
+    random_vec(in.center, 3);
+    random_vec(in.up, 3);
+    in.angle = random_range(0.1f, 3.0f);
+    in.x = random_range(0.5f, 4.0f);
+    in.y = random_range(0.01f, 1.0f);
+    in.z = random_range(10.0f, 1000.0f);
+
+    math_layout_run_column_major(column, &in);
+    math_layout_run_row_major(row, &in);
+    for (u32 k = 0; k < MATH_LAYOUT_RESULTS; ++k) {
+      mismatches[k] += memcmp(column[k], row[k], sizeof(column[k])) != 0;
+    }
+  }
+  bool ok = true;
+  for (u32 k = 0; k < MATH_LAYOUT_RESULTS; ++k) {
+    if (!mismatches[k]) continue;
+    ERROR("Math test: %-21s %u results differ between layouts",
+          layout_names[k], mismatches[k]);
+    ok = false;
+  }
+  if (ok) LOG("Math test: both matrix layouts agree");
+  return ok;
+}
+
+bool math_test_run(void) {
+  LOG("Math test: simd backend %d, %u samples, simd bound %.0f ulp",
+      MATH_SIMD, MATH_TEST_SAMPLES, SIMD_MAX_ULP);
+  srand(1);
+  bool ok = test_vec3();
+  ok &= test_vec4();
+  ok &= test_matrices();
+  ok &= test_inverses();
+  ok &= test_kernel_normals();
+  ok &= test_layouts();
+  if (!ok) ERROR("Math test: failed");
+  return ok;
+}
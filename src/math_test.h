@@ -0,0 +1,9 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// checks the simd paths of c-lib/math.h against their _ref versions, within
+// the bounds math.h documents, the inverses and normal matrices against f64,
+// and the mat4x4 functions of both storage layouts against each other. needs
+// no window or gl context. returns false if any check fails
+bool math_test_run(void);
@@ -0,0 +1,107 @@
+#include "pass_timer.h"
+
+#include <glad/glad.h>
+#include <string.h>
+
+#include "c-lib/misc.h"
+#include "c-lib/time.h"
+
+#define PASS_TIMER_SMOOTHING 0.1 // weight of the newest frame in the average
+
+typedef struct {
+  u32 queries[PASS_TIMER_MAX_QUERIES];
+  pass_timer_t passes[PASS_TIMER_MAX_QUERIES]; // what each used query timed
+  u32 count;                                   // queries used this frame
+} timer_frame_t;
+
+static struct {
+  timer_frame_t frames[PASS_TIMER_LATENCY];
+  u32 frame;         // slot being recorded
+  pass_timer_t open; // only one GL_TIME_ELAPSED query may run at a time
+  u64 cpu_start[PASS_TIMER_COUNT];
+  f64 cpu_frame[PASS_TIMER_COUNT]; // ms, summed over the current frame
+  pass_timings_t results;
+} timers;
+
+static const char* const pass_names[PASS_TIMER_COUNT] = {
+    [PASS_TIMER_WORLD] = "world",
+    [PASS_TIMER_OVERLAY] = "overlay",
+    [PASS_TIMER_SPRITES] = "sprites",
+};
+
+void pass_timer_init(void) {
+  memset(&timers, 0, sizeof(timers));
+  timers.open = PASS_TIMER_COUNT;
+  for (u32 i = 0; i < PASS_TIMER_LATENCY; ++i) {
+    glGenQueries(PASS_TIMER_MAX_QUERIES, timers.frames[i].queries);
+  }
+}
+
+void pass_timer_destroy(void) {
+  for (u32 i = 0; i < PASS_TIMER_LATENCY; ++i) {
+    glDeleteQueries(PASS_TIMER_MAX_QUERIES, timers.frames[i].queries);
+  }
+}
+
+static f64 smooth(f64 average, f64 sample) {
+  return average + (sample - average) * PASS_TIMER_SMOOTHING;
+}
+
+// sums the queries of the oldest slot in the ring before it is reused
+static void read_back(timer_frame_t* frame) {
+  if (frame->count == 0) return;
+
+  // queries complete in order, so if the last one is ready they all are
+  u32 available = 0;
+  glGetQueryObjectuiv(frame->queries[frame->count - 1],
+                      GL_QUERY_RESULT_AVAILABLE, &available);
+  if (available) {
+    f64 gpu[PASS_TIMER_COUNT] = {0};
+    for (u32 i = 0; i < frame->count; ++i) {
+      u64 ns = 0;
+      glGetQueryObjectui64v(frame->queries[i], GL_QUERY_RESULT, &ns);
+      gpu[frame->passes[i]] += ns / 1000000.0;
+    }
+    for (u32 p = 0; p < PASS_TIMER_COUNT; ++p) {
+      timers.results.gpu_ms[p] = smooth(timers.results.gpu_ms[p], gpu[p]);
+    }
+  }
+  // a gpu running more than PASS_TIMER_LATENCY frames behind drops samples
+  frame->count = 0;
+}
+
+void pass_timer_frame_begin(void) {
+  ASSERT(timers.open == PASS_TIMER_COUNT, "pass timer left running");
+  for (u32 p = 0; p < PASS_TIMER_COUNT; ++p) {
+    timers.results.cpu_ms[p] =
+        smooth(timers.results.cpu_ms[p], timers.cpu_frame[p]);
+    timers.cpu_frame[p] = 0.0;
+  }
+
+  timers.frame = (timers.frame + 1) % PASS_TIMER_LATENCY;
+  read_back(&timers.frames[timers.frame]);
+}
+
+void pass_timer_begin(pass_timer_t pass) {
+  timers.cpu_start[pass] = time_ns();
+
+  timer_frame_t* frame = &timers.frames[timers.frame];
+  if (timers.open != PASS_TIMER_COUNT ||
+      frame->count == PASS_TIMER_MAX_QUERIES) {
+    return; // cpu time only
+  }
+  glBeginQuery(GL_TIME_ELAPSED, frame->queries[frame->count]);
+  frame->passes[frame->count++] = pass;
+  timers.open = pass;
+}
+
+void pass_timer_end(pass_timer_t pass) {
+  timers.cpu_frame[pass] += (time_ns() - timers.cpu_start[pass]) / 1000000.0;
+  if (timers.open != pass) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  timers.open = PASS_TIMER_COUNT;
+}
+
+const pass_timings_t* pass_timer_results(void) { return &timers.results; }
+
+const char* pass_timer_name(pass_timer_t pass) { return pass_names[pass]; }
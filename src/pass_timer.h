@@ -0,0 +1,33 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// cpu and gpu time spent drawing each pass. gpu times come from
+// GL_TIME_ELAPSED queries kept in a ring and read PASS_TIMER_LATENCY frames
+// later, so reading them never stalls on the gpu
+#define PASS_TIMER_LATENCY 4
+#define PASS_TIMER_MAX_QUERIES 16 // per frame, a pass may be timed repeatedly
+
+typedef enum {
+  PASS_TIMER_WORLD,   // 3d objects, lit and unlit, including the light gizmo
+  PASS_TIMER_OVERLAY, // screen space objects such as the quad
+  PASS_TIMER_SPRITES, // text and other batched sprites
+
+  PASS_TIMER_COUNT,
+} pass_timer_t;
+
+typedef struct {
+  f64 cpu_ms[PASS_TIMER_COUNT]; // smoothed over the last frames
+  f64 gpu_ms[PASS_TIMER_COUNT];
+} pass_timings_t;
+
+void pass_timer_init(void);
+void pass_timer_destroy(void);
+
+// once per frame, before any pass is timed
+void pass_timer_frame_begin(void);
+void pass_timer_begin(pass_timer_t pass);
+void pass_timer_end(pass_timer_t pass);
+
+const pass_timings_t* pass_timer_results(void);
+const char* pass_timer_name(pass_timer_t pass);
@@ -1,12 +1,24 @@
 #include "render.h"
 
+#include <float.h>
 #include <glad/glad.h>
 #include <stddef.h>
 
 #include "GLFW/glfw3.h"
+#include "c-lib/jobs.h"
 #include "c-lib/math.h"
 #include "c-lib/misc.h"
+#include "c-lib/profile.h"
+#include "cull.h"
 #include "file_io.h"
+#include "font.h"
+#include "gl_state.h"
+#include "headless.h"
+#include "pass_timer.h"
+#include "render_queue.h"
+#include "render_thread.h"
+#include "sprite_batch.h"
+#include "transform_batch.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -18,15 +30,159 @@
 
 #define RAD(_t) (_t * (M_PI / 180.0f))
 
-#define MAX_OBJECTS 10
-static mesh_t meshes[MAX_OBJECTS];
-static material_t materials[MAX_OBJECTS];
-static render_object_t objects[MAX_OBJECTS];
-static u32 object_count = 0;
+// clip planes of the world projection, the sort depth is normalized to far
+#define CAMERA_NEAR 0.1f
+#define CAMERA_FAR 100.0f
+
+// per instance attributes start after the vertex attributes
+#define INSTANCE_ATTRIB_MODEL 3 // 4 slots, one per row
+#define INSTANCE_ATTRIB_COLOR 7
+#define INSTANCE_ATTRIB_NORMAL 8 // 3 slots, one per row
+#define INSTANCE_ATTRIB_LAST (INSTANCE_ATTRIB_NORMAL + 2)
+#define INSTANCE_MIN_RUN 2 // smaller runs use the regular draw path
+
+// indices per parallel_for range at the least, below that a job costs more
+// than the work it hands out
+#define GRAIN_MODELS 128
+#define GRAIN_CULL 512
+#define GRAIN_SPHERE_ROWS 8
+
+typedef struct {
+  mat4x4 model;
+  vec4 color;
+  mat3x3 normal;
+} instance_t;
+
+// std140 layouts, matching the blocks declared in the shaders
+typedef struct {
+  mat4x4 view_proj;
+} camera_block_t;
+
+typedef struct {
+  vec4 position; // normalized, w unused
+  vec4 color;
+  vec4 ambient_intensity;
+} light_block_t;
+
+typedef enum {
+  FRAME_UBO_CAMERA_WORLD,
+  FRAME_UBO_CAMERA_SCREEN,
+  FRAME_UBO_LIGHT,
+
+  FRAME_UBO_COUNT,
+} frame_ubo_section_t;
+
+// one draw call, with everything the render thread needs to issue it so it
+// never looks at objects the main thread may be changing
+typedef struct {
+  const shader_t* shader; // the instanced variant for instanced draws
+  u32 vao, index_count;
+  u32 texture, sampler;
+  render_pass_t pass;
+  u32 first, count; // range of the packet's instances
+} draw_cmd_t;
+
+// a recorded frame, executed on the render thread
+typedef struct {
+  iv2 viewport;
+  u8* frame_ubo; // copy of the staging data, uploaded if frame_ubo_dirty
+  bool frame_ubo_dirty;
+  DYNLIST(instance_t) instances; // model and color of every draw
+  DYNLIST(draw_cmd_t) draws;
+  sprite_list_t sprites;
+  const char* dump_path;  // headless only, written once the frame is drawn
+  pass_timings_t timings; // filled in by the render thread once executed
+  gl_state_stats_t gl_stats;
+} render_packet_t;
+
+#define MAX_SHADERS 8
+static shader_t shaders[MAX_SHADERS];
+static u32 shader_count = 0;
+
+// everything else is owned by pools and referred to by handle
+static pool_t meshes;    // mesh_t
+static pool_t textures;  // texture_t
+static pool_t materials; // material_t
+static pool_t objects;   // render_object_t
+
+static render_scene_t scene;
+
+static bool headless; // drawing offscreen, there is no window
+static GLFWwindow* render_window;
 static camera_t camera;
+static vec3 view_eye; // the blended camera position the view is built from
+static frustum_t frustum; // extracted from camera.view_proj
+static cull_batch_t cull_batch;
+static transform_batch_t transform_batch;
+static DYNLIST(u32) transform_objects; // dense index of each batch entry
+static iv2 window_size, framebuffer_size;
+static mat4x4 ortho; // screen space projection for 2d
+static bool screen_dirty = true;
 
 static vec3 light_pos = (vec3){0.0f, 0.0f, 3.0f};
 static sprite_sheet_t font_sheet;
+static render_stats_t stats;
+static render_queue_t queue;
+static render_packet_t packets[RENDER_PACKET_COUNT];
+static render_packet_t* recording; // between render_begin and render_end
+static u32 recording_slot;
+static pass_timings_t pass_timings; // as of the last packet in the slot
+static gl_state_stats_t gl_stats;
+
+// only touched by the render thread once it has started
+static u32 instance_vbo;
+static size_t instance_vbo_capacity; // bytes
+static iv2 viewport;
+static GLsync frame_fence; // the last executed frame is done on the gpu
+
+// every per frame uniform lives in one buffer, written once per frame
+static u32 frame_ubo;
+static u32 frame_ubo_offsets[FRAME_UBO_COUNT];
+static u32 frame_ubo_size;
+static u8* frame_ubo_staging;
+static bool frame_ubo_dirty = true;   // staging is refilled on render_update
+static bool frame_ubo_changed = true; // not yet copied into a packet
+
+// indexed by uniform_t, matched against the active uniforms of each program
+static const char* const uniform_names[UNIFORM_COUNT] = {
+    [UNIFORM_MODEL] = "u_model",
+    [UNIFORM_NORMAL_MATRIX] = "u_normal_matrix",
+    [UNIFORM_OBJECT_COLOR] = "u_object_color",
+    [UNIFORM_TEXTURE0] = "u_texture0",
+};
+
+static const pass_timer_t pass_timers[RENDER_PASS_COUNT] = {
+    [RENDER_PASS_WORLD] = PASS_TIMER_WORLD,
+    [RENDER_PASS_OVERLAY] = PASS_TIMER_OVERLAY,
+};
+
+static const char* const uniform_block_names[UNIFORM_BLOCK_COUNT] = {
+    [UNIFORM_BLOCK_CAMERA] = "camera_block",
+    [UNIFORM_BLOCK_LIGHT] = "light_block",
+};
+
+// the columns of the orientation, with the camera looking down its -z
+static void update_camera_basis(void) {
+  mat3x4 rotation;
+  quat_to_mat3x4(rotation, camera.orientation);
+  for (u32 i = 0; i < 3; ++i) {
+    camera.right[i] = rotation[i][0];
+    camera.up[i] = rotation[i][1];
+    camera.front[i] = -rotation[i][2];
+  }
+}
+
+// yaw turns around the world up axis and pitch around the camera's own right
+// axis, so the horizon stays level. both in degrees
+static void turn_camera(f32 yaw, f32 pitch) {
+  quat turn;
+  quat_from_axis_angle(turn, (vec3){0.0f, 1.0f, 0.0f}, -RAD(yaw));
+  quat_mul(camera.orientation, turn, camera.orientation);
+  quat_from_axis_angle(turn, (vec3){1.0f, 0.0f, 0.0f}, RAD(pitch));
+  quat_mul(camera.orientation, camera.orientation, turn);
+  quat_normalize(camera.orientation, camera.orientation);
+  update_camera_basis();
+}
 
 static void mouse_callback(GLFWwindow* window, f64 xpos, f64 ypos) {
   (void)window;
@@ -46,17 +202,23 @@ static void mouse_callback(GLFWwindow* window, f64 xpos, f64 ypos) {
   xoffset *= sensitivity;
   yoffset *= sensitivity;
 
-  camera.yaw += xoffset;
-  camera.pitch += yoffset;
-
-  if (camera.pitch > 89.0f) camera.pitch = 89.0f;
-  if (camera.pitch < -89.0f) camera.pitch = -89.0f;
+  // keeps looking less than straight up or down
+  const f32 pitch = asinf(camera.front[1]) * (180.0f / M_PI);
+  turn_camera(xoffset, clamp(pitch + (f32)yoffset, -89.0f, 89.0f) - pitch);
+  camera.dirty = true;
 }
 
 static void framebuffer_size_callback(GLFWwindow* window, int width,
                                       int height) {
   (void)window;
-  glViewport(0, 0, width, height);
+  framebuffer_size = (iv2){width, height}; // recorded into the next packet
+  camera.dirty = true;
+}
+
+static void window_size_callback(GLFWwindow* window, int width, int height) {
+  (void)window;
+  window_size = (iv2){width, height};
+  screen_dirty = true;
 }
 
 static GLFWwindow* init_window(u32 width, u32 height) {
@@ -82,11 +244,24 @@ static GLFWwindow* init_window(u32 width, u32 height) {
   return window;
 }
 
+// the shaders default to column major blocks and instance matrices, the row
+// major build flips them with a define
+#if MATH_COLUMN_MAJOR
+#define SHADER_LAYOUT_DEFINES ""
+#else
+#define SHADER_LAYOUT_DEFINES "#define MATH_ROW_MAJOR\n"
+#endif
+
 static u32 compile_shader(const char* const shader_src, GLenum shader_type) {
   int success;
   char log[512];
   GLuint shader = glCreateShader(shader_type);
-  glShaderSource(shader, 1, &shader_src, NULL);
+  // defines have to come after the #version line
+  const char* body = strchr(shader_src, '\n');
+  body = body ? body + 1 : shader_src + strlen(shader_src);
+  const char* sources[] = {shader_src, SHADER_LAYOUT_DEFINES, body};
+  const GLint lengths[] = {(GLint)(body - shader_src), -1, -1};
+  glShaderSource(shader, 3, sources, lengths);
   glCompileShader(shader);
   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
   if (!success) {
@@ -96,7 +271,49 @@ static u32 compile_shader(const char* const shader_src, GLenum shader_type) {
   return shader;
 }
 
-static u32 link_shaders(u32 shader_vert, u32 shader_frag) {
+// the only place that should hit the driver's string lookup
+static i32 uniform_location(u32 prog, const char* name) {
+  ++stats.uniform_lookups;
+  ++stats.uniform_lookups_total;
+  return glGetUniformLocation(prog, name);
+}
+
+static void reflect_uniforms(shader_t* shader) {
+  for (u32 i = 0; i < UNIFORM_COUNT; ++i) shader->uniforms[i] = -1;
+
+  int count;
+  glGetProgramiv(shader->program, GL_ACTIVE_UNIFORMS, &count);
+  shader->active_uniforms = count;
+
+  for (int i = 0; i < count; ++i) {
+    char name[64];
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(shader->program, i, sizeof(name), NULL, &size, &type,
+                       name);
+    for (u32 u = 0; u < UNIFORM_COUNT; ++u) {
+      if (strcmp(name, uniform_names[u]) == 0) {
+        shader->uniforms[u] = uniform_location(shader->program, name);
+        break;
+      }
+    }
+  }
+
+  for (u32 b = 0; b < UNIFORM_BLOCK_COUNT; ++b) {
+    u32 index = glGetUniformBlockIndex(shader->program, uniform_block_names[b]);
+    if (index != GL_INVALID_INDEX) {
+      glUniformBlockBinding(shader->program, index, b);
+    }
+  }
+
+  // samplers never change units, so set them once here instead of per draw
+  if (shader->uniforms[UNIFORM_TEXTURE0] != -1) {
+    gl_state_use_program(shader->program);
+    glUniform1i(shader->uniforms[UNIFORM_TEXTURE0], 0);
+  }
+}
+
+static shader_t link_shaders(u32 shader_vert, u32 shader_frag) {
   int success;
   char log[512];
   GLuint shader_prog = glCreateProgram();
@@ -110,11 +327,15 @@ static u32 link_shaders(u32 shader_vert, u32 shader_frag) {
   }
   glDeleteShader(shader_vert);
   glDeleteShader(shader_frag);
-  return shader_prog;
+
+  shader_t shader = {.program = shader_prog};
+  reflect_uniforms(&shader);
+  return shader;
 }
 
-static u32 create_shader_program(const char* const path_vert,
-                                 const char* const path_fragment) {
+static shader_t create_shader_program(const char* const path_vert,
+                                      const char* const path_fragment) {
+  PROFILE_FUNC();
   file_t vert = io_file_read(path_vert);
   file_t frag = io_file_read(path_fragment);
 
@@ -122,12 +343,102 @@ static u32 create_shader_program(const char* const path_vert,
 
   u32 shader_vert = compile_shader(vert.data, GL_VERTEX_SHADER);
   u32 shader_frag = compile_shader(frag.data, GL_FRAGMENT_SHADER);
-  u32 shader_prog = link_shaders(shader_vert, shader_frag);
+  shader_t shader = link_shaders(shader_vert, shader_frag);
 
   free(vert.data);
   free(frag.data);
 
-  return shader_prog;
+  return shader;
+}
+
+// attribute offsets are part of the vao state, so every instanced draw points
+// the bound vao at where its run starts in the shared instance buffer
+static void point_instance_attribs(u32 first_instance) {
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, instance_vbo);
+  size_t base = first_instance * sizeof(instance_t);
+  for (u32 i = 0; i < 4; ++i) {
+    glVertexAttribPointer(INSTANCE_ATTRIB_MODEL + i, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(instance_t),
+                          (void*)(base + offsetof(instance_t, model[i])));
+  }
+  glVertexAttribPointer(INSTANCE_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(instance_t),
+                        (void*)(base + offsetof(instance_t, color)));
+  for (u32 i = 0; i < 3; ++i) {
+    glVertexAttribPointer(INSTANCE_ATTRIB_NORMAL + i, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(instance_t),
+                          (void*)(base + offsetof(instance_t, normal[i])));
+  }
+}
+
+static void create_frame_ubo(void) {
+  static const u32 section_sizes[FRAME_UBO_COUNT] = {
+      [FRAME_UBO_CAMERA_WORLD] = sizeof(camera_block_t),
+      [FRAME_UBO_CAMERA_SCREEN] = sizeof(camera_block_t),
+      [FRAME_UBO_LIGHT] = sizeof(light_block_t),
+  };
+
+  // each bound range has to start on the driver's alignment
+  int alignment;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  u32 offset = 0;
+  for (u32 i = 0; i < FRAME_UBO_COUNT; ++i) {
+    offset = (offset + alignment - 1) / alignment * alignment;
+    frame_ubo_offsets[i] = offset;
+    offset += section_sizes[i];
+  }
+  frame_ubo_size = offset;
+  frame_ubo_staging = (u8*)calloc(1, frame_ubo_size);
+  ASSERT(frame_ubo_staging);
+
+  glGenBuffers(1, &frame_ubo);
+  gl_state_bind_buffer(GL_UNIFORM_BUFFER, frame_ubo);
+  glBufferData(GL_UNIFORM_BUFFER, frame_ubo_size, NULL, GL_DYNAMIC_DRAW);
+
+  // the light never changes range, the camera range changes per pass
+  gl_state_bind_uniform_range(UNIFORM_BLOCK_LIGHT, frame_ubo,
+                              frame_ubo_offsets[FRAME_UBO_LIGHT],
+                              sizeof(light_block_t));
+}
+
+static void bind_camera_block(render_pass_t pass) {
+  frame_ubo_section_t section = pass == RENDER_PASS_WORLD
+                                    ? FRAME_UBO_CAMERA_WORLD
+                                    : FRAME_UBO_CAMERA_SCREEN;
+  gl_state_bind_uniform_range(UNIFORM_BLOCK_CAMERA, frame_ubo,
+                              frame_ubo_offsets[section],
+                              sizeof(camera_block_t));
+}
+
+static void create_instance_buffer(void) {
+  instance_vbo_capacity = 64 * sizeof(instance_t);
+  glGenBuffers(1, &instance_vbo);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, instance_vbo);
+  glBufferData(GL_ARRAY_BUFFER, instance_vbo_capacity, NULL, GL_STREAM_DRAW);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+}
+
+// aabb over the vertex positions, and the sphere around it for culling
+static void compute_bounds(mesh_t* mesh, const u8* positions, u32 count,
+                           size_t stride) {
+  vec3_mov(mesh->aabb_min, (vec3){FLT_MAX, FLT_MAX, FLT_MAX});
+  vec3_mov(mesh->aabb_max, (vec3){-FLT_MAX, -FLT_MAX, -FLT_MAX});
+  for (u32 i = 0; i < count; ++i) {
+    const f32* p = (const f32*)(positions + i * stride);
+    for (u32 j = 0; j < 3; ++j) {
+      mesh->aabb_min[j] = min(mesh->aabb_min[j], p[j]);
+      mesh->aabb_max[j] = max(mesh->aabb_max[j], p[j]);
+    }
+  }
+
+  vec3_add(mesh->center, mesh->aabb_min, mesh->aabb_max);
+  vec3_scale(mesh->center, mesh->center, 0.5f);
+  mesh->radius = 0.0f;
+  for (u32 i = 0; i < count; ++i) {
+    vec3 d;
+    vec3_sub(d, (const f32*)(positions + i * stride), mesh->center);
+    mesh->radius = max(mesh->radius, vec3_len(d));
+  }
 }
 
 // vertices_size and indices_size are the number of bytes in the respective arrs
@@ -140,29 +451,39 @@ static mesh_t create_mesh(vertex3d_t* vertices, u32 vertices_size, u32* indices,
   glGenBuffers(1, &vbo);
   glGenBuffers(1, &ebo);
 
-  glBindVertexArray(vao);
+  gl_state_bind_vertex_array(vao);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, vertices_size, vertices, GL_STATIC_DRAW);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_size, indices, GL_STATIC_DRAW);
 
   EN_ATTRIB(0, 3, position, vertex3d_t);   // [x, y, z]
   EN_ATTRIB(1, 3, normal, vertex3d_t);     // [x, y, z]
   EN_ATTRIB(2, 2, tex_coords, vertex3d_t); // [u, v]
 
+  // advanced once per instance instead of once per vertex
+  point_instance_attribs(0);
+  for (u32 i = INSTANCE_ATTRIB_MODEL; i <= INSTANCE_ATTRIB_LAST; ++i) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+
   // do not unbind EBO before unbinding VAO, as the VAO tracks ebo bindings
-  glBindVertexArray(0);                     // unbind vao
-  glBindBuffer(GL_ARRAY_BUFFER, 0);         // unbind vbo
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // unbind ebo
+  gl_state_bind_vertex_array(0);                    // unbind vao
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);         // unbind vbo
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0); // unbind ebo
 
-  return (mesh_t){
+  mesh_t mesh = {
       .vao = vao,
       .vbo = vbo,
       .ebo = ebo,
       .index_count = indices_size / sizeof(u32),
   };
+  compute_bounds(&mesh, (const u8*)&vertices[0].position,
+                 vertices_size / sizeof(vertex3d_t), sizeof(vertex3d_t));
+  return mesh;
 }
 
 static mesh_t create_cube_mesh(void) {
@@ -251,20 +572,28 @@ static mesh_t create_ramp_mesh(void) {
   return create_mesh(vertices, sizeof(vertices), indices, sizeof(indices));
 }
 
-static mesh_t create_sphere_mesh(u32 x_segments, u32 y_segments) {
-  u32 vertices_size = (x_segments + 1) * (y_segments + 1);
-  vertex3d_t* vertices =
-      (vertex3d_t*)malloc(vertices_size * sizeof(vertex3d_t));
-  ASSERT(vertices);
-  for (u32 y = 0; y <= y_segments; ++y) {
+typedef struct {
+  vertex3d_t* vertices;
+  u32 x_segments, y_segments;
+  const f32* sin_theta; // per column, shared by every row
+  const f32* cos_theta;
+} sphere_rows_t;
+
+static void sphere_rows(u32 begin, u32 end, void* data) {
+  const sphere_rows_t* rows = data;
+  vertex3d_t* vertices = rows->vertices;
+  const u32 x_segments = rows->x_segments, y_segments = rows->y_segments;
+  for (u32 y = begin; y < end; ++y) {
+    f32 y_segment = (f32)y / (f32)y_segments; // normalize phi
+    // phi only goes north to south: pi
+    f32 sin_phi, cos_phi;
+    fast_sincosf(y_segment * M_PI, &sin_phi, &cos_phi);
     for (u32 x = 0; x <= x_segments; ++x) {
       f32 x_segment = (f32)x / (f32)x_segments; // normalize theta
-      f32 y_segment = (f32)y / (f32)y_segments; // normalize phi
-      // theta wraps around 2pi rad and phi only goes north to south: pi
       // convert spherical to cartesian coordinates
-      f32 x_pos = cos(x_segment * 2.0f * M_PI) * sin(y_segment * M_PI);
-      f32 y_pos = cos(y_segment * M_PI);
-      f32 z_pos = sin(x_segment * 2.0f * M_PI) * sin(y_segment * M_PI);
+      f32 x_pos = rows->cos_theta[x] * sin_phi;
+      f32 y_pos = cos_phi;
+      f32 z_pos = rows->sin_theta[x] * sin_phi;
       u32 index = y * (x_segments + 1) + x;
       vertices[index].position[0] = x_pos;
       vertices[index].position[1] = y_pos;
@@ -277,6 +606,28 @@ static mesh_t create_sphere_mesh(u32 x_segments, u32 y_segments) {
       vertices[index].tex_coords[1] = y_segment;
     }
   }
+}
+
+static mesh_t create_sphere_mesh(u32 x_segments, u32 y_segments) {
+  u32 vertices_size = (x_segments + 1) * (y_segments + 1);
+  vertex3d_t* vertices =
+      (vertex3d_t*)malloc(vertices_size * sizeof(vertex3d_t));
+  ASSERT(vertices);
+
+  // theta wraps around 2pi rad, the same angles for every row
+  f32* theta = (f32*)malloc(3 * (x_segments + 1) * sizeof(f32));
+  ASSERT(theta);
+  f32* sin_theta = theta + x_segments + 1;
+  f32* cos_theta = sin_theta + x_segments + 1;
+  for (u32 x = 0; x <= x_segments; ++x) {
+    theta[x] = (f32)x / (f32)x_segments * 2.0f * M_PI;
+  }
+  fast_sincos_n(sin_theta, cos_theta, theta, x_segments + 1);
+
+  sphere_rows_t rows = {vertices, x_segments, y_segments, sin_theta, cos_theta};
+  parallel_for(y_segments + 1, GRAIN_SPHERE_ROWS, sphere_rows, &rows);
+  free(theta);
+
   u32 indices_size = x_segments * y_segments * 6;
   u32* indices = (u32*)malloc(indices_size * sizeof(u32));
   ASSERT(indices);
@@ -315,208 +666,269 @@ static mesh_t create_quad_mesh(void) {
   glGenBuffers(1, &vbo);
   glGenBuffers(1, &ebo);
 
-  glBindVertexArray(vao);
+  gl_state_bind_vertex_array(vao);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
                GL_STATIC_DRAW);
 
   EN_ATTRIB(0, 3, position, vertex2d_t);
   EN_ATTRIB(1, 2, tex_coords, vertex2d_t);
 
-  glBindVertexArray(0);                     // unbind vao
-  glBindBuffer(GL_ARRAY_BUFFER, 0);         // unbind vbo
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // unbind ebo (after vao)
+  gl_state_bind_vertex_array(0);                    // unbind vao
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);         // unbind vbo
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0); // unbind ebo (after vao)
 
-  return (mesh_t){
+  mesh_t mesh = {
       .vao = vao,
       .vbo = vbo,
       .ebo = ebo,
       .index_count = sizeof(indices) / sizeof(u32),
   };
+  compute_bounds(&mesh, (const u8*)&vertices[0].position, ARRLEN(vertices),
+                 sizeof(vertex2d_t));
+  return mesh;
 }
 
-static u32 create_white_texture(void) {
+static texture_t create_white_texture(void) {
   // this will be the blank texture so that whatever color we wish to draw to
   // the object, it will be that color only
   u32 texture_id;
   glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
+  gl_state_bind_texture(0, texture_id);
 
   u8 solid_white[4] = {255, 255, 255, 255};
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
                solid_white);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  return texture_id;
+  gl_state_bind_texture(0, 0);
+  return (texture_t){.id = texture_id, .width = 1, .height = 1};
+}
+
+typedef struct {
+  const char* path;
+  u8* pixels;
+  int width, height, channel_count;
+} image_t;
+
+// decoded on a worker, only the upload needs the gl context
+static void load_image(void* data) {
+  PROFILE_FUNC();
+  image_t* image = data;
+  image->pixels = stbi_load(image->path, &image->width, &image->height,
+                            &image->channel_count, 0);
+  ASSERT(image->pixels, "failed to load image from stb image: %s",
+         image->path);
 }
 
-static u32 create_texture(const char* path) {
+static texture_t create_texture(image_t* image) {
+  PROFILE_FUNC();
   u32 texture_id;
   glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
+  gl_state_bind_texture(0, texture_id);
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-  int width, height, channel_count;
-  u8* image_data = stbi_load(path, &width, &height, &channel_count, 0);
-  ASSERT(image_data, "failed to load image from stb image: %s", path);
-  GLenum format = channel_count == 3 ? GL_RGB : GL_RGBA;
-  glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-               GL_UNSIGNED_BYTE, image_data);
+  GLenum format = image->channel_count == 3 ? GL_RGB : GL_RGBA;
+  glTexImage2D(GL_TEXTURE_2D, 0, format, image->width, image->height, 0,
+               format, GL_UNSIGNED_BYTE, image->pixels);
   glGenerateMipmap(GL_TEXTURE_2D);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
-  stbi_image_free(image_data);
-  return texture_id;
+  gl_state_bind_texture(0, 0);
+  stbi_image_free(image->pixels);
+  image->pixels = NULL;
+  return (texture_t){
+      .id = texture_id, .width = image->width, .height = image->height};
 }
 
-static material_t create_material(u32 shader_prog, vec4 color, u32 texture_id) {
-  return (material_t){
-      .shader_program = shader_prog,
-      .color = {color[0], color[1], color[2], color[3]},
-      .texture_id = texture_id,
-  };
+static handle_t add_mesh(mesh_t mesh) {
+  handle_t handle = pool_create(&meshes);
+  *(mesh_t*)pool_get(&meshes, handle) = mesh;
+  return handle;
 }
 
-static void update_models(f32 angle) {
-  int width, height;
-  glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
-  f32 aspect_ratio = (f32)width / (f32)height;
-
-  mat4x4 rotation;
-  mat4x4_identity(rotation);
-  // mat4x4_rotate_y(rotation, rotation, angle);
-  mat4x4_rotate_x(rotation, rotation, angle / 2.0f);
-  // mat4x4_rotate_z(rotation, rotation, angle / 3.0f);
-
-  for (u32 i = 0; i < object_count; ++i) mat4x4_identity(objects[i].model);
-
-  mat4x4_translate(objects[0].model, -1.0f, 0.0f, 0.0f);
-  mat4x4_translate(objects[1].model, 1.0f, 0.0f, 0.0f);
-  mat4x4_translate(objects[2].model, light_pos[0], light_pos[1], light_pos[2]);
-  mat4x4_translate(objects[3].model, 0.0f, 2.0f, 0.0f);
-
-  mat4x4_mul(objects[0].model, objects[0].model, rotation);
-  mat4x4_mul(objects[1].model, objects[1].model, rotation);
-  mat4x4_scale_aniso(objects[2].model, objects[2].model, 0.2f, 0.2f, 0.2f);
-  mat4x4_scale_aniso(objects[3].model, objects[3].model, 0.8f, 0.8f, 0.8f);
-
-  mat4x4 view;
-  vec3 camera_front;
-  get_camera_front(camera_front);
+static handle_t add_texture(texture_t texture) {
+  handle_t handle = pool_create(&textures);
+  *(texture_t*)pool_get(&textures, handle) = texture;
+  return handle;
+}
 
-  vec3 camera_target;
-  vec3_add(camera_target, camera.position, camera_front);
-  mat4x4_look_at(view, camera.position, camera_target,
-                 (vec3){0.0f, 1.0f, 0.0f});
+static handle_t create_material(shader_t* shader, vec4 color,
+                                handle_t texture, u32 sampler) {
+  ASSERT(pool_get(&textures, texture));
+  handle_t handle = pool_create(&materials);
+  *(material_t*)pool_get(&materials, handle) = (material_t){
+      .shader = shader,
+      .color = {color[0], color[1], color[2], color[3]},
+      .texture = texture,
+      .sampler = sampler,
+  };
+  return handle;
+}
 
-  mat4x4 proj;
-  mat4x4_perspective(proj, RAD(45.0f), aspect_ratio, 0.1f, 100.0f);
-  mat4x4_mul(camera.view_proj, proj, view);
+// objects start white and get their model built on the next render_update
+static handle_t add_object(render_object_t object) {
+  ASSERT(pool_get(&meshes, object.mesh) &&
+         pool_get(&materials, object.material));
+  handle_t handle = pool_create(&objects);
+  render_object_t* dst = pool_get(&objects, handle);
+  *dst = object;
+  vec4_mov(dst->color, WHITE);
+  dst->dirty = true;
+  return handle;
 }
 
-GLFWwindow* render_init(u32 width, u32 height) {
-  GLFWwindow* window = init_window(width, height);
+static mesh_t* get_mesh(handle_t mesh) {
+  mesh_t* result = pool_get(&meshes, mesh);
+  ASSERT(result, "stale mesh handle %u", mesh);
+  return result;
+}
 
-  camera = (camera_t){
-      .position = {0.0f, 0.5f, 5.0f},
-      .yaw = -90.0f, // look down the -z axis
-      .pitch = 0.0f,
-      .first_mouse = true,
-  };
+// largest axis scale of the upper 3x3, so the sphere covers any rotation
+static f32 max_axis_scale(mat3x4 const m) {
+  f32 result = 0.0f;
+  for (u32 col = 0; col < 3; ++col) {
+    vec3 axis = {m[0][col], m[1][col], m[2][col]};
+    result = max(result, vec3_len(axis));
+  }
+  return result;
+}
 
-  int framebuffer_width, framebuffer_height;
-  glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+static void update_bounds(render_object_t* object) {
+  const mesh_t* mesh = get_mesh(object->mesh);
+  mat3x4_mul_point(object->bounds, object->model, mesh->center);
+  object->bounds[3] = mesh->radius * max_axis_scale(object->model);
+}
 
-  glfwSetCursorPosCallback(window, mouse_callback);
-  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+static void lerp_transform(transform_t* result, const transform_t* a,
+                           const transform_t* b, f32 t) {
+  vec3_lerp(result->position, a->position, b->position, t);
+  quat_nlerp(result->rotation, a->rotation, b->rotation, t);
+  vec3_lerp(result->scale, a->scale, b->scale, t);
+}
 
-  glViewport(0, 0, framebuffer_width, framebuffer_height);
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+static void batch_transform(u32 slot, const transform_t* t) {
+  transform_batch.x[slot] = t->position[0];
+  transform_batch.y[slot] = t->position[1];
+  transform_batch.z[slot] = t->position[2];
+  transform_batch.qx[slot] = t->rotation[0];
+  transform_batch.qy[slot] = t->rotation[1];
+  transform_batch.qz[slot] = t->rotation[2];
+  transform_batch.qw[slot] = t->rotation[3];
+  transform_batch.sx[slot] = t->scale[0];
+  transform_batch.sy[slot] = t->scale[1];
+  transform_batch.sz[slot] = t->scale[2];
+}
 
-  stbi_set_flip_vertically_on_load(1);
+// objects the last step moved are blended every frame, the rest are only
+// rebuilt when they are placed somewhere new. the ones to rebuild are packed
+// at the start of the range and built in one batch
+static void update_model_range(u32 begin, u32 end, void* data) {
+  const f32 alpha = *(const f32*)data;
+  u32 slot = begin;
+  for (u32 i = begin; i < end; ++i) {
+    render_object_t* object = pool_at(&objects, i);
+    if (object->moving) {
+      transform_t blended;
+      lerp_transform(&blended, &object->previous, &object->transform, alpha);
+      batch_transform(slot, &blended);
+      transform_objects[slot++] = i;
+    } else if (object->dirty) {
+      object->previous = object->transform;
+      batch_transform(slot, &object->transform);
+      transform_objects[slot++] = i;
+    }
+    object->dirty = false;
+  }
 
-  u32 tex_cube = create_texture("res/map_wall.png");
-  u32 tex_ramp = create_texture("res/map_floor.png");
-  u32 tex_font = create_texture("res/font.png");
-  u32 tex_white = create_white_texture();
+  transform_batch_run(&transform_batch, begin, slot);
+  for (u32 j = begin; j < slot; ++j) {
+    render_object_t* object = pool_at(&objects, transform_objects[j]);
+    mat3x4_mov(object->model, transform_batch.model[j]);
+    memcpy(object->normal, transform_batch.normal[j], sizeof(mat3x3));
+    update_bounds(object);
+  }
+}
 
-  u32 default_prog = create_shader_program("src/shaders/default.vert",
-                                           "src/shaders/default.frag");
-  u32 light_prog =
-      create_shader_program("src/shaders/light.vert", "src/shaders/light.frag");
+static void update_models(f32 alpha) {
+  PROFILE_FUNC();
+  const render_object_t* light = get_render_object(scene.light);
+  if (light->moving || light->dirty) frame_ubo_dirty = true;
+  transform_batch_resize(&transform_batch, pool_size(&objects));
+  dynlist_resize_no_contract(transform_objects, pool_size(&objects));
+  parallel_for(pool_size(&objects), GRAIN_MODELS, update_model_range, &alpha);
+}
 
-  meshes[0] = create_cube_mesh();
-  meshes[1] = create_ramp_mesh();
-  meshes[2] = create_sphere_mesh(64, 64);
-  meshes[3] = create_quad_mesh();
-  materials[0] = create_material(light_prog, TURQUOISE, tex_cube);
-  materials[1] = create_material(light_prog, WHITE, tex_ramp);
-  materials[2] = create_material(light_prog, RED, tex_white);
-  materials[3] = create_material(default_prog, YELLOW, tex_white);
-  materials[4] = create_material(default_prog, WHITE, tex_white);
-  materials[5] = create_material(default_prog, WHITE, tex_font);
-
-  object_count = 5;
-  objects[0] = (render_object_t){.mesh = &meshes[0], .material = &materials[0]};
-  objects[1] = (render_object_t){.mesh = &meshes[1], .material = &materials[2]};
-  objects[2] = (render_object_t){.mesh = &meshes[0], .material = &materials[3]};
-  objects[3] = (render_object_t){.mesh = &meshes[2], .material = &materials[2]};
-  objects[4] = (render_object_t){.mesh = &meshes[3], .material = &materials[4]};
+static void update_camera(f32 alpha) {
+  const bool moving =
+      memcmp(camera.previous, camera.position, sizeof(vec3)) != 0;
+  if (!camera.dirty && !moving) return;
+
+  // the position is simulated and blended, looking around is not. the view
+  // is the inverse of where the camera is placed
+  mat3x4 placement, view;
+  vec3_lerp(view_eye, camera.previous, camera.position, alpha);
+  quat_to_mat3x4(placement, camera.orientation);
+  placement[0][3] = view_eye[0];
+  placement[1][3] = view_eye[1];
+  placement[2][3] = view_eye[2];
+  mat3x4_invert_rigid(view, placement);
+
+  f32 aspect_ratio = (f32)framebuffer_size.x / (f32)framebuffer_size.y;
+  mat4x4 proj;
+  mat4x4_perspective(proj, RAD(45.0f), aspect_ratio, CAMERA_NEAR, CAMERA_FAR);
+  mat4x4_mul_mat3x4(camera.view_proj, proj, view);
+  frustum_extract(&frustum, camera.view_proj);
+  camera.dirty = false;
+  frame_ubo_dirty = true;
+}
 
-  font_sheet.width = 128;
-  font_sheet.height = 128;
-  font_sheet.cell_width = 8;
-  font_sheet.cell_height = 8;
-  font_sheet.material = &materials[5];
-  font_sheet.mesh = &meshes[3];
+static void update_screen(void) {
+  if (!screen_dirty) return;
 
-  LOG("Render window and geometry/meshes initialized");
+  f32 width = (f32)window_size.x, height = (f32)window_size.y;
+  mat4x4_ortho(ortho, 0.0f, width, 0.0f, height, -1.0f, 1.0f);
 
-  return window;
+  // the quad stays centered on the screen
+  render_object_t* quad = get_render_object(scene.quad);
+  quad->transform.position[0] = width * 0.5f;
+  quad->transform.position[1] = height * 0.5f;
+  quad->dirty = true;
+  screen_dirty = false;
+  frame_ubo_dirty = true;
 }
 
-static void destroy_mesh(mesh_t* mesh) {
-  glDeleteVertexArrays(1, &mesh->vao);
-  glDeleteBuffers(1, &mesh->vbo);
-  glDeleteBuffers(1, &mesh->ebo);
-}
-static void destroy_material(material_t* material) {
-  glDeleteProgram(material->shader_program);
-}
-void render_destroy(GLFWwindow* window) {
-  for (u32 i = 0; i < object_count; ++i) {
-    destroy_mesh(&meshes[i]);
+static void cull_range(u32 begin, u32 end, void* data) {
+  (void)data;
+  for (u32 i = begin; i < end; ++i) {
+    const render_object_t* object = pool_at(&objects, i);
+    cull_batch.x[i] = object->bounds[0];
+    cull_batch.y[i] = object->bounds[1];
+    cull_batch.z[i] = object->bounds[2];
+    // overlay objects are in screen space, an infinite sphere always passes
+    cull_batch.radius[i] =
+        object->pass == RENDER_PASS_WORLD ? object->bounds[3] : FLT_MAX;
   }
-  destroy_material(&materials[0]);
-  glfwDestroyWindow(window); // optional
-  glfwTerminate();
-}
 
-vec3* get_light_pos(void) { return &light_pos; }
-camera_t* get_camera(void) { return &camera; };
-void get_camera_front(vec3 result) {
-  result[0] = cos(RAD(camera.yaw)) * cos(RAD(camera.pitch)); // x
-  result[1] = sin(RAD(camera.pitch));                        // y
-  result[2] = sin(RAD(camera.yaw)) * cos(RAD(camera.pitch)); // z
-  vec3_normalize(result, result);
-}
+  cull_batch_run(&cull_batch, &frustum, begin, end);
 
-void render_begin(void) {
-  glClearColor(0.2f, 0.2f, 0.2f, 0.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  for (u32 i = begin; i < end; ++i) {
+    render_object_t* object = pool_at(&objects, i);
+    object->visible = cull_batch.visible[i];
+  }
 }
 
-void render_end(void) { glfwSwapBuffers(glfwGetCurrentContext()); }
+// tests every object's bounds against the frustum, in dense pool order
+static void cull_objects(void) {
+  PROFILE_FUNC();
+  cull_batch_resize(&cull_batch, pool_size(&objects));
+  parallel_for(pool_size(&objects), GRAIN_CULL, cull_range, NULL);
+}
 
-static void render_object(render_object_t* object, bool lit) {
+static void update_frame_ubo(void) {
   /* lighting
 
      Diffuse Lighting Equation: R = D * I * cos(T)
@@ -563,92 +975,595 @@ static void render_object(render_object_t* object, bool lit) {
      no angle of incidence in the diffuse calculation. Thus, the formula is
      simply: ambient light intensity * diffuse surface color.
   */
-  update_models(glfwGetTime());
-  ASSERT(object->mesh && object->material);
-
-  u32 prog = object->material->shader_program;
-  glUseProgram(prog);
-
-  // transpose is true, because we are tracking in row major format formats
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_model"), 1, GL_TRUE,
-                     &object->model[0][0]);
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_view_proj"), 1, GL_TRUE,
-                     (const GLfloat*)camera.view_proj);
-  glUniform4fv(glGetUniformLocation(prog, "u_object_color"), 1,
-               object->material->color);
-  if (lit) {
-    vec3 light_pos_norm;
-    vec3_mov(light_pos_norm, light_pos);
-    vec3_normalize(light_pos_norm, light_pos_norm);
-    glUniform3fv(glGetUniformLocation(prog, "u_light_pos"), 1, light_pos_norm);
-    glUniform4fv(glGetUniformLocation(prog, "u_light_color"), 1,
-                 (vec4){0.8f, 0.8f, 0.8f, 1.0f});
-    glUniform4fv(glGetUniformLocation(prog, "u_ambient_intensity"), 1,
-                 (vec4){0.2f, 0.2f, 0.2f, 1.0f});
-  }
-
-  glUniform1i(glGetUniformLocation(prog, "u_texture0"), 0);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, object->material->texture_id);
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  glBindVertexArray(object->mesh->vao);
-  glDrawElements(GL_TRIANGLES, object->mesh->index_count, GL_UNSIGNED_INT,
-                 NULL);
-  glBindVertexArray(0);
-  glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-static void render_quad_impl(render_object_t* object) {
-  ASSERT(object->mesh && object->material);
-
-  int width, height;
-  glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
-  mat4x4_identity(object->model);
-  mat4x4_translate(object->model, width * 0.5f, height * 0.5f, 0.0f);
-  mat4x4_scale_aniso(object->model, object->model, 5, 5, 1.0f);
-  mat4x4 ortho;
-  mat4x4_ortho(ortho, 0.0f, (f32)width, 0.0f, (f32)height, -1.0f, 1.0f);
-
-  glDisable(GL_DEPTH_TEST);
-  u32 prog = object->material->shader_program;
-  glUseProgram(prog);
-
-  // transpose is true, because we are tracking in row major format formats
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_model"), 1, GL_TRUE,
-                     &object->model[0][0]);
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_view_proj"), 1, GL_TRUE,
-                     (const GLfloat*)ortho);
-  glUniform4fv(glGetUniformLocation(prog, "u_object_color"), 1,
-               object->material->color);
-
-  glUniform1i(glGetUniformLocation(prog, "u_texture0"), 0);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, object->material->texture_id);
-
-  // for 2d pixels
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  glBindVertexArray(object->mesh->vao);
-  glDrawElements(GL_TRIANGLES, object->mesh->index_count, GL_UNSIGNED_INT,
-                 NULL);
-  glBindVertexArray(0);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  glEnable(GL_DEPTH_TEST);
-}
-
-static void calculate_sprite_tex_coords(vec4 result, f32 row, f32 column,
-                                        f32 texture_width, f32 texture_height,
-                                        f32 cell_width, f32 cell_height) {
-  f32 w = 1.0f / (texture_width / cell_width);
-  f32 h = 1.0f / (texture_height / cell_height);
+  if (!frame_ubo_dirty) return;
+
+  u8* data = frame_ubo_staging;
+  camera_block_t* world =
+      (camera_block_t*)(data + frame_ubo_offsets[FRAME_UBO_CAMERA_WORLD]);
+  camera_block_t* screen =
+      (camera_block_t*)(data + frame_ubo_offsets[FRAME_UBO_CAMERA_SCREEN]);
+  light_block_t* light =
+      (light_block_t*)(data + frame_ubo_offsets[FRAME_UBO_LIGHT]);
+
+  // the blocks are declared in the layout of the build, so the matrices are
+  // copied as is
+  mat4x4_mov(world->view_proj, camera.view_proj);
+  mat4x4_mov(screen->view_proj, ortho);
+
+  // follows the gizmo, so lighting is blended between steps along with it
+  const render_object_t* gizmo = get_render_object(scene.light);
+  vec3 light_world = {gizmo->model[0][3], gizmo->model[1][3],
+                      gizmo->model[2][3]};
+  vec3_normalize(light->position, light_world);
+  light->position[3] = 0.0f;
+  vec4_mov(light->color, (vec4){0.8f, 0.8f, 0.8f, 1.0f});
+  vec4_mov(light->ambient_intensity, (vec4){0.2f, 0.2f, 0.2f, 1.0f});
+
+  frame_ubo_dirty = false;
+  frame_ubo_changed = true;
+}
+
+void render_step(f64 time) {
+  PROFILE_FUNC();
+  // the state a step starts from is what the frames after it blend from
+  pool_each(&objects, render_object_t, object) {
+    if (!object->moving) continue;
+    object->previous = object->transform;
+    object->moving = false;
+    object->dirty = true; // rebuilt once more in case it stops here
+  }
+  if (memcmp(camera.previous, camera.position, sizeof(vec3)) != 0) {
+    vec3_mov(camera.previous, camera.position);
+    camera.dirty = true;
+  }
+
+  render_object_t* cube = get_render_object(scene.cube);
+  render_object_t* ramp = get_render_object(scene.ramp);
+  // one turn every 4 pi seconds, wrapped while still in double precision
+  const f32 angle = fmod(time / 2.0, 2.0 * M_PI);
+  quat_from_axis_angle(cube->transform.rotation, (vec3){1.0f, 0.0f, 0.0f},
+                       angle);
+  quat_from_axis_angle(ramp->transform.rotation, (vec3){1.0f, 0.0f, 0.0f},
+                       angle);
+  cube->moving = true;
+  ramp->moving = true;
+
+  // moved by input during the last step
+  render_object_t* light = get_render_object(scene.light);
+  if (memcmp(light->transform.position, light_pos, sizeof(vec3)) != 0) {
+    vec3_mov(light->transform.position, light_pos);
+    light->moving = true;
+  }
+}
+
+// once per frame, before any render_* draw calls
+void render_update(f32 alpha) {
+  PROFILE_FUNC();
+  update_screen();
+  update_camera(alpha);
+  update_models(alpha);
+  cull_objects();
+  update_frame_ubo();
+}
+
+// the render thread executes recorded packets with the functions below, and
+// owns the gl context while it runs
+
+// orphans the old storage so the driver never waits on last frame's draws
+static void upload_instances(const render_packet_t* packet) {
+  size_t size = dynlist_size(packet->instances) * sizeof(instance_t);
+  if (size == 0) return;
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, instance_vbo);
+  while (instance_vbo_capacity < size) instance_vbo_capacity *= 2;
+  glBufferData(GL_ARRAY_BUFFER, instance_vbo_capacity, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, size, packet->instances);
+}
+
+static void draw_single(const render_packet_t* packet, const draw_cmd_t* cmd) {
+  const i32* u = cmd->shader->uniforms;
+  const instance_t* instance = &packet->instances[cmd->first];
+  glUniformMatrix4fv(u[UNIFORM_MODEL], 1, MATH_GL_TRANSPOSE,
+                     &instance->model[0][0]);
+  // mat3x3 is stored by rows in either layout, the shader reads them as
+  // columns and multiplies from the left, so nothing is transposed
+  glUniformMatrix3fv(u[UNIFORM_NORMAL_MATRIX], 1, GL_FALSE,
+                     &instance->normal[0][0]);
+  glUniform4fv(u[UNIFORM_OBJECT_COLOR], 1, instance->color);
+  glDrawElements(GL_TRIANGLES, cmd->index_count, GL_UNSIGNED_INT, NULL);
+}
+
+static void draw_instanced(const draw_cmd_t* cmd) {
+  point_instance_attribs(cmd->first);
+  glDrawElementsInstanced(GL_TRIANGLES, cmd->index_count, GL_UNSIGNED_INT,
+                          NULL, cmd->count);
+}
+
+static void execute_draws(const render_packet_t* packet) {
+  render_pass_t last_pass = RENDER_PASS_COUNT;
+  for (u32 i = 0; i < dynlist_size(packet->draws); ++i) {
+    const draw_cmd_t* cmd = &packet->draws[i];
+    if (cmd->pass != last_pass) {
+      if (last_pass != RENDER_PASS_COUNT) {
+        pass_timer_end(pass_timers[last_pass]);
+      }
+      pass_timer_begin(pass_timers[cmd->pass]);
+      gl_state_set_depth_test(cmd->pass == RENDER_PASS_WORLD);
+      bind_camera_block(cmd->pass);
+      last_pass = cmd->pass;
+    }
+    gl_state_use_program(cmd->shader->program);
+    gl_state_bind_texture(0, cmd->texture);
+    gl_state_bind_sampler(0, cmd->sampler);
+    gl_state_bind_vertex_array(cmd->vao);
+
+    if (cmd->count >= INSTANCE_MIN_RUN) {
+      draw_instanced(cmd);
+    } else {
+      draw_single(packet, cmd);
+    }
+  }
+  if (last_pass != RENDER_PASS_COUNT) pass_timer_end(pass_timers[last_pass]);
+}
+
+// sprites are drawn last, over everything else in the frame
+static void execute_sprites(const render_packet_t* packet) {
+  if (sprite_list_count(&packet->sprites) == 0) return;
+  gl_state_set_depth_test(false);
+  bind_camera_block(RENDER_PASS_OVERLAY);
+  pass_timer_begin(PASS_TIMER_SPRITES);
+  sprite_batch_flush(&packet->sprites);
+  pass_timer_end(PASS_TIMER_SPRITES);
+}
+
+// keeps the gpu at most one frame behind this thread, drivers would
+// otherwise queue several frames and add their latency on top
+static void wait_for_last_frame(void) {
+  if (!frame_fence) return;
+  PROFILE_FUNC();
+  while (glClientWaitSync(frame_fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                          100000000) == GL_TIMEOUT_EXPIRED) {
+  }
+  glDeleteSync(frame_fence);
+  frame_fence = NULL;
+}
+
+static void execute_packet(u32 slot) {
+  PROFILE_FUNC();
+  render_packet_t* packet = &packets[slot];
+  wait_for_last_frame();
+  gl_state_frame_reset();
+  pass_timer_frame_begin();
+
+  if (packet->viewport.x != viewport.x || packet->viewport.y != viewport.y) {
+    viewport = packet->viewport;
+    glViewport(0, 0, viewport.x, viewport.y);
+  }
+  if (packet->frame_ubo_dirty) {
+    // respecifying the whole store orphans the copy last frame may still read
+    gl_state_bind_buffer(GL_UNIFORM_BUFFER, frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, frame_ubo_size, packet->frame_ubo,
+                 GL_DYNAMIC_DRAW);
+  }
+  glClearColor(0.2f, 0.2f, 0.2f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  upload_instances(packet);
+  execute_draws(packet);
+  execute_sprites(packet);
+
+  if (packet->dump_path && !headless_write_ppm(packet->dump_path)) {
+    ERROR("failed to write %s", packet->dump_path);
+  }
+  if (!headless) {
+    PROFILE_SCOPE("glfwSwapBuffers");
+    glfwSwapBuffers(render_window);
+  }
+  frame_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  packet->timings = *pass_timer_results();
+  packet->gl_stats = *gl_state_get_stats();
+}
+
+static void bind_context(bool current) {
+  if (headless) {
+    headless_bind_context(current);
+  } else {
+    glfwMakeContextCurrent(current ? render_window : NULL);
+  }
+}
+
+GLFWwindow* render_init(u32 width, u32 height, bool offscreen) {
+  PROFILE_FUNC();
+  headless = offscreen;
+  GLFWwindow* window = NULL;
+  if (headless) {
+    headless_init(width, height);
+    framebuffer_size = window_size = (iv2){width, height};
+  } else {
+    window = init_window(width, height);
+    glfwGetFramebufferSize(window, &framebuffer_size.x, &framebuffer_size.y);
+    glfwGetWindowSize(window, &window_size.x, &window_size.y);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowSizeCallback(window, window_size_callback);
+  }
+
+  camera = (camera_t){
+      .position = {0.0f, 0.5f, 5.0f},
+      .previous = {0.0f, 0.5f, 5.0f},
+      .orientation = {0.0f, 0.0f, 0.0f, 1.0f},
+      .first_mouse = true,
+      .dirty = true,
+  };
+  update_camera_basis();
+
+  viewport = framebuffer_size;
+  glViewport(0, 0, viewport.x, viewport.y);
+  gl_state_init();
+  pass_timer_init();
+  gl_state_set_depth_test(true);
+  gl_state_set_blend(true);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  stbi_set_flip_vertically_on_load(1);
+
+  pool_init(&meshes, sizeof(mesh_t), 64);
+  pool_init(&textures, sizeof(texture_t), 64);
+  pool_init(&materials, sizeof(material_t), 64);
+  pool_init(&objects, sizeof(render_object_t), 1024);
+
+  // decoded while the shaders compile
+  image_t images[] = {{.path = "res/map_wall.png"}, {.path = "res/font.png"}};
+  job_counter_t images_loaded = {0};
+  for (u32 i = 0; i < ARRLEN(images); ++i) {
+    jobs_run(load_image, &images[i], &images_loaded);
+  }
+
+  shader_count = 5;
+  shaders[0] = create_shader_program("src/shaders/default.vert",
+                                     "src/shaders/default.frag");
+  shaders[1] =
+      create_shader_program("src/shaders/light.vert", "src/shaders/light.frag");
+  shaders[2] = create_shader_program("src/shaders/default_instanced.vert",
+                                     "src/shaders/default.frag");
+  shaders[3] = create_shader_program("src/shaders/light_instanced.vert",
+                                     "src/shaders/light.frag");
+  shaders[4] = create_shader_program("src/shaders/sprite.vert",
+                                     "src/shaders/default.frag");
+  shader_t* default_prog = &shaders[0];
+  shader_t* light_prog = &shaders[1];
+  default_prog->instanced = &shaders[2];
+  light_prog->instanced = &shaders[3];
+
+  jobs_wait(&images_loaded);
+  handle_t tex_cube = add_texture(create_texture(&images[0]));
+  handle_t tex_font = add_texture(create_texture(&images[1]));
+  handle_t tex_white = add_texture(create_white_texture());
+
+  create_instance_buffer();
+  create_frame_ubo();
+  sprite_batch_init(&shaders[4]);
+  for (u32 i = 0; i < RENDER_PACKET_COUNT; ++i) {
+    packets[i].instances = dynlist_create(instance_t, 64);
+    packets[i].draws = dynlist_create(draw_cmd_t, 64);
+    packets[i].frame_ubo = calloc(1, frame_ubo_size);
+    sprite_list_init(&packets[i].sprites);
+  }
+
+  handle_t cube_mesh = add_mesh(create_cube_mesh());
+  handle_t ramp_mesh = add_mesh(create_ramp_mesh());
+  handle_t sphere_mesh = add_mesh(create_sphere_mesh(64, 64));
+  handle_t quad_mesh = add_mesh(create_quad_mesh());
+  // mipmapped for 3d meshes, and unfiltered for 2d pixels
+  u32 linear = gl_state_sampler(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT);
+  u32 nearest = gl_state_sampler(GL_NEAREST, GL_NEAREST, GL_REPEAT);
+
+  handle_t mat_cube =
+      create_material(light_prog, TURQUOISE, tex_cube, linear);
+  handle_t mat_red = create_material(light_prog, RED, tex_white, linear);
+  handle_t mat_light =
+      create_material(default_prog, YELLOW, tex_white, linear);
+  handle_t mat_quad =
+      create_material(default_prog, WHITE, tex_white, nearest);
+  handle_t mat_font = create_material(default_prog, WHITE, tex_font, nearest);
+
+  scene.cube = add_object((render_object_t){
+      .mesh = cube_mesh,
+      .material = mat_cube,
+      .transform = {.position = {-1.0f, 0.0f, 0.0f},
+                    .rotation = {0, 0, 0, 1},
+                    .scale = {1, 1, 1}},
+  });
+  scene.ramp = add_object((render_object_t){
+      .mesh = ramp_mesh,
+      .material = mat_red,
+      .transform = {.position = {1.0f, 0.0f, 0.0f},
+                    .rotation = {0, 0, 0, 1},
+                    .scale = {1, 1, 1}},
+  });
+  scene.light = add_object((render_object_t){
+      .mesh = cube_mesh,
+      .material = mat_light,
+      .transform = {.position = {light_pos[0], light_pos[1], light_pos[2]},
+                    .rotation = {0, 0, 0, 1},
+                    .scale = {0.2f, 0.2f, 0.2f}},
+  });
+  scene.sphere = add_object((render_object_t){
+      .mesh = sphere_mesh,
+      .material = mat_red,
+      .transform = {.position = {0.0f, 2.0f, 0.0f},
+                    .rotation = {0, 0, 0, 1},
+                    .scale = {0.8f, 0.8f, 0.8f}},
+  });
+  scene.quad = add_object((render_object_t){
+      .mesh = quad_mesh,
+      .material = mat_quad,
+      .pass = RENDER_PASS_OVERLAY,
+      .transform = {.rotation = {0, 0, 0, 1}, .scale = {5.0f, 5.0f, 1.0f}},
+  });
+
+  render_queue_init(&queue);
+  cull_batch_init(&cull_batch);
+  transform_batch_init(&transform_batch);
+  transform_objects = dynlist_create(u32, 1024);
+
+  font_sheet.width = 128;
+  font_sheet.height = 128;
+  font_sheet.cell_width = 8;
+  font_sheet.cell_height = 8;
+  font_sheet.material = mat_font;
+  font_init(&font_sheet);
+
+  render_window = window;
+  render_thread_start(&(render_thread_desc_t){bind_context, execute_packet});
+  LOG("Render window and geometry/meshes initialized");
+
+  return window;
+}
+
+static void destroy_mesh(mesh_t* mesh) {
+  gl_state_delete_vertex_array(mesh->vao);
+  gl_state_delete_buffer(mesh->vbo);
+  gl_state_delete_buffer(mesh->ebo);
+}
+static void destroy_shader(shader_t* shader) {
+  gl_state_delete_program(shader->program);
+}
+void render_destroy(GLFWwindow* window) {
+  PROFILE_FUNC();
+  render_thread_stop();
+  if (frame_fence) glDeleteSync(frame_fence);
+  for (u32 i = 0; i < RENDER_PACKET_COUNT; ++i) {
+    dynlist_destroy(packets[i].instances);
+    dynlist_destroy(packets[i].draws);
+    free(packets[i].frame_ubo);
+    sprite_list_destroy(&packets[i].sprites);
+  }
+  pool_each(&meshes, mesh_t, mesh) { destroy_mesh(mesh); }
+  pool_each(&textures, texture_t, texture) {
+    gl_state_delete_texture(texture->id);
+  }
+  pool_destroy(&objects);
+  pool_destroy(&materials);
+  pool_destroy(&textures);
+  pool_destroy(&meshes);
+  for (u32 i = 0; i < shader_count; ++i) {
+    destroy_shader(&shaders[i]);
+  }
+  render_queue_destroy(&queue);
+  cull_batch_destroy(&cull_batch);
+  transform_batch_destroy(&transform_batch);
+  dynlist_destroy(transform_objects);
+  pass_timer_destroy();
+  sprite_batch_destroy();
+  font_destroy();
+  gl_state_delete_buffer(instance_vbo);
+  gl_state_delete_buffer(frame_ubo);
+  free(frame_ubo_staging);
+  gl_state_destroy();
+  if (headless) {
+    headless_destroy();
+  } else {
+    glfwDestroyWindow(window); // optional
+    glfwTerminate();
+  }
+}
+
+vec3* get_light_pos(void) { return &light_pos; }
+camera_t* get_camera(void) { return &camera; };
+const render_scene_t* get_scene(void) { return &scene; }
+render_stats_t* get_render_stats(void) { return &stats; }
+const pass_timings_t* get_pass_timings(void) { return &pass_timings; }
+const gl_state_stats_t* get_gl_stats(void) { return &gl_stats; }
+iv2 get_window_size(void) { return window_size; }
+
+void set_camera(vec3 const position, f32 yaw, f32 pitch) {
+  vec3_mov(camera.position, position);
+  // yaw is measured from +x towards +z, where the identity looks down -z
+  quat_identity(camera.orientation);
+  turn_camera(yaw + 90.0f, pitch);
+  camera.dirty = true;
+}
+
+render_object_t* get_render_object(handle_t object) {
+  render_object_t* result = pool_get(&objects, object);
+  ASSERT(result, "stale object handle %u", object);
+  return result;
+}
+
+material_t* get_material(handle_t material) {
+  material_t* result = pool_get(&materials, material);
+  ASSERT(result, "stale material handle %u", material);
+  return result;
+}
+
+texture_t* get_texture(handle_t texture) {
+  texture_t* result = pool_get(&textures, texture);
+  ASSERT(result, "stale texture handle %u", texture);
+  return result;
+}
+
+handle_t render_object_create(handle_t mesh, handle_t material) {
+  return add_object((render_object_t){
+      .mesh = mesh,
+      .material = material,
+      .transform = {.rotation = {0, 0, 0, 1}, .scale = {1.0f, 1.0f, 1.0f}},
+  });
+}
+
+void render_object_destroy(handle_t object) { pool_remove(&objects, object); }
+
+// waits until the next packet is free, then records the frame into it
+void render_begin(void) {
+  PROFILE_FUNC();
+  ASSERT(!recording, "render_begin called twice");
+  recording_slot = render_thread_acquire();
+  recording = &packets[recording_slot];
+  pass_timings = recording->timings;
+  gl_stats = recording->gl_stats;
+
+  dynlist_resize_no_contract(recording->instances, 0);
+  dynlist_resize_no_contract(recording->draws, 0);
+  sprite_list_clear(&recording->sprites);
+  sprite_batch_record(&recording->sprites);
+  recording->dump_path = NULL;
+
+  stats.uniform_lookups = 0;
+  stats.draw_calls = 0;
+  stats.instanced_draw_calls = 0;
+  stats.instances = 0;
+  stats.sprites = 0;
+  stats.visible = 0;
+  stats.culled = 0;
+}
+
+// hands the recorded frame to the render thread
+void render_end(void) {
+  PROFILE_FUNC();
+  ASSERT(recording, "render_end called without render_begin");
+  sprite_batch_record(NULL);
+  stats.sprites = sprite_list_count(&recording->sprites);
+  stats.draw_calls += sprite_list_draw_calls(&recording->sprites);
+
+  recording->viewport = framebuffer_size;
+  recording->frame_ubo_dirty = frame_ubo_changed;
+  if (frame_ubo_changed) {
+    memcpy(recording->frame_ubo, frame_ubo_staging, frame_ubo_size);
+    frame_ubo_changed = false;
+  }
+
+  recording = NULL;
+  render_thread_submit(recording_slot);
+}
+
+void render_dump(const char* path) {
+  ASSERT(headless && recording, "dumps are recorded, headless only");
+  recording->dump_path = path;
+}
+
+static void object_color(vec4 result, const render_object_t* object,
+                         const material_t* material) {
+  for (u32 i = 0; i < 4; ++i) {
+    result[i] = material->color[i] * object->color[i];
+  }
+}
+
+static bool can_share_draw(const render_object_t* a,
+                           const render_object_t* b) {
+  return a->pass == RENDER_PASS_WORLD && b->pass == RENDER_PASS_WORLD &&
+         a->material == b->material && a->mesh == b->mesh;
+}
+
+// splits the sorted queue into draws of the same mesh and material, the ones
+// that are long enough are drawn instanced
+static void record_draws(void) {
+  const u32 n = dynlist_size(queue.items);
+  for (u32 i = 0; i < n;) {
+    const render_object_t* first = queue.items[i].object;
+    const material_t* material = get_material(first->material);
+    const mesh_t* mesh = get_mesh(first->mesh);
+    u32 end = i + 1;
+    if (material->shader->instanced) {
+      while (end < n && can_share_draw(first, queue.items[end].object)) {
+        ++end;
+      }
+    }
+
+    const bool instanced = end - i >= INSTANCE_MIN_RUN;
+    *dynlist_push(recording->draws) = (draw_cmd_t){
+        .shader = instanced ? material->shader->instanced : material->shader,
+        .vao = mesh->vao,
+        .index_count = mesh->index_count,
+        .texture = get_texture(material->texture)->id,
+        .sampler = material->sampler,
+        .pass = first->pass,
+        .first = dynlist_size(recording->instances),
+        .count = end - i,
+    };
+    for (u32 j = i; j < end; ++j) {
+      const render_object_t* object = queue.items[j].object;
+      instance_t* instance = dynlist_push(recording->instances);
+      mat3x4_to_mat4x4(instance->model, object->model);
+      memcpy(instance->normal, object->normal, sizeof(mat3x3));
+      object_color(instance->color, object, material);
+    }
+
+    ++stats.draw_calls;
+    if (instanced) {
+      ++stats.instanced_draw_calls;
+      stats.instances += end - i;
+    }
+    i = end;
+  }
+}
+
+// distance along the view direction, normalized to the far plane. both the
+// model and the eye are blended, so this is the depth the frame is drawn at
+static f32 view_depth(const render_object_t* object) {
+  vec3 to_object = {object->model[0][3] - view_eye[0],
+                    object->model[1][3] - view_eye[1],
+                    object->model[2][3] - view_eye[2]};
+  return vec3_dot(to_object, camera.front) / CAMERA_FAR;
+}
+
+void render_submit(handle_t handle) {
+  render_object_t* object = get_render_object(handle);
+  if (!object->visible) {
+    ++stats.culled;
+    return;
+  }
+  ++stats.visible;
+
+  const material_t* material = get_material(object->material);
+  // the tint multiplies into the material color, so either can make it blend
+  bool translucent = material->color[3] * object->color[3] < 1.0f;
+  f32 depth = object->pass == RENDER_PASS_WORLD ? view_depth(object) : 0.0f;
+
+  // the key only keeps the low bits of each index, enough to group draws
+  u64 key = render_key(object->pass, translucent, material->shader - shaders,
+                       handle_index(object->material),
+                       handle_index(material->texture),
+                       handle_index(object->mesh), depth);
+  render_queue_push(&queue, key, object);
+}
+
+// sorts everything submitted since the last flush and records it as draws
+void render_flush(void) {
+  PROFILE_FUNC();
+  ASSERT(recording, "render_flush called outside render_begin/render_end");
+  render_queue_sort(&queue);
+  record_draws();
+  render_queue_clear(&queue);
+}
+
+void sprite_sheet_tex_coords(vec4 result, const sprite_sheet_t* sheet,
+                             f32 row, f32 column) {
+  f32 w = 1.0f / (sheet->width / sheet->cell_width);
+  f32 h = 1.0f / (sheet->height / sheet->cell_height);
   f32 x = column * w;
   // flip the row so that 0,0 index in the texture coordinates is the top left
-  f32 y = ((texture_height / cell_height - 1) - row) * h;
+  f32 y = ((sheet->height / sheet->cell_height - 1) - row) * h;
   result[0] = x;
   result[1] = y;
   result[2] = x + w;
@@ -657,72 +1572,22 @@ static void calculate_sprite_tex_coords(vec4 result, f32 row, f32 column,
 
 void render_sprite_frame(f32 row, f32 column, vec2 position, vec2 size,
                          vec4 color, bool is_flipped) {
-  ASSERT(font_sheet.material && font_sheet.mesh);
-
-  int width, height;
-  glfwGetWindowSize(glfwGetCurrentContext(), &width, &height);
-  mat4x4 ortho;
-  mat4x4_ortho(ortho, 0.0f, (f32)width, 0.0f, (f32)height, -1.0f, 1.0f);
-
-  u32 prog = font_sheet.material->shader_program;
-  glUseProgram(prog);
-
-  mat4x4 model;
-  mat4x4_identity(model);
-  mat4x4_translate(model, position[0], position[1], 0.0f);
-  mat4x4_scale_aniso(model, model, size[0], size[1], 1.0f);
-
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_model"), 1, GL_TRUE,
-                     &model[0][0]);
-  glUniformMatrix4fv(glGetUniformLocation(prog, "u_view_proj"), 1, GL_TRUE,
-                     (const GLfloat*)ortho);
-  glUniform4fv(glGetUniformLocation(prog, "u_object_color"), 1, color);
+  const material_t* material = get_material(font_sheet.material);
 
   vec4 tex_coords;
-  calculate_sprite_tex_coords(tex_coords, row, column, font_sheet.width,
-                              font_sheet.height, font_sheet.cell_width,
-                              font_sheet.cell_height);
+  sprite_sheet_tex_coords(tex_coords, &font_sheet, row, column);
   if (is_flipped) {
     f32 tmp = tex_coords[0];
     tex_coords[0] = tex_coords[2];
     tex_coords[2] = tmp;
   }
 
-  f32 u_min = tex_coords[0];
-  f32 v_min = tex_coords[1];
-  f32 u_max = tex_coords[2];
-  f32 v_max = tex_coords[3];
-
-  vertex2d_t vertices[] = {
-      {{0.5f, 0.5f, 0.0f}, {u_max, v_max}},   // top right
-      {{0.5f, -0.5f, 0.0f}, {u_max, v_min}},  // bottom right
-      {{-0.5f, -0.5f, 0.0f}, {u_min, v_min}}, // bottom left
-      {{-0.5f, 0.5f, 0.0f}, {u_min, v_max}},  // top left
-  };
-
-  glBindVertexArray(font_sheet.mesh->vao);
-  glBindBuffer(GL_ARRAY_BUFFER, font_sheet.mesh->vbo);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-
-  glUniform1i(glGetUniformLocation(prog, "u_texture0"), 0);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, font_sheet.material->texture_id);
-
-  // for 2d pixels
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-  glDisable(GL_DEPTH_TEST);
-  glDrawElements(GL_TRIANGLES, font_sheet.mesh->index_count, GL_UNSIGNED_INT,
-                 NULL);
-
-  glEnable(GL_DEPTH_TEST);
-  glBindVertexArray(0);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  sprite_batch_push(get_texture(material->texture)->id, material->sampler,
+                    position, size, tex_coords, color);
 }
 
-void render_cube(void) { render_object(&objects[0], true); }
-void render_ramp(void) { render_object(&objects[1], true); }
-void render_light(void) { render_object(&objects[2], false); }
-void render_sphere(void) { render_object(&objects[3], true); }
-void render_quad(void) { render_quad_impl(&objects[4]); }
+void render_cube(void) { render_submit(scene.cube); }
+void render_ramp(void) { render_submit(scene.ramp); }
+void render_light(void) { render_submit(scene.light); }
+void render_sphere(void) { render_submit(scene.sphere); }
+void render_quad(void) { render_submit(scene.quad); }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "c-lib/math.h"
+#include "c-lib/pool.h"
 #include "c-lib/types.h"
+#include "gl_state.h"
+#include "pass_timer.h"
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -20,51 +23,154 @@ typedef struct {
 typedef struct {
   u32 vao, vbo, ebo;
   u32 index_count;
+  vec3 aabb_min, aabb_max; // model space
+  vec3 center;             // bounding sphere, center of the aabb
+  f32 radius;
 } mesh_t; // raw geometry on the GPU
 
 typedef struct {
-  u32 shader_program;
+  u32 id;
+  i32 width, height;
+} texture_t;
+
+typedef enum {
+  UNIFORM_MODEL,
+  UNIFORM_NORMAL_MATRIX,
+  UNIFORM_OBJECT_COLOR,
+  UNIFORM_TEXTURE0,
+
+  UNIFORM_COUNT,
+} uniform_t; // per draw uniforms
+
+typedef enum {
+  UNIFORM_BLOCK_CAMERA,
+  UNIFORM_BLOCK_LIGHT,
+
+  UNIFORM_BLOCK_COUNT,
+} uniform_block_t; // per frame uniforms, also used as the binding index
+
+typedef struct shader_s {
+  u32 program;
+  i32 uniforms[UNIFORM_COUNT]; // locations, -1 if not active in the program
+  u32 active_uniforms;
+  struct shader_s* instanced; // variant reading per instance attributes
+} shader_t; // linked program with its uniform locations resolved
+
+typedef struct {
+  shader_t* shader;
   vec4 color;
-  u32 texture_id;
+  handle_t texture;
+  u32 sampler; // filtering/wrap state, shared between materials
 } material_t; // appearance of an object
 
 typedef struct {
-  material_t* material;
-  mesh_t* mesh;
-  mat4x4 model;
+  vec3 position;
+  quat rotation; // unit length
+  vec3 scale;
+} transform_t;
+
+typedef enum {
+  RENDER_PASS_WORLD,   // perspective camera, depth tested
+  RENDER_PASS_OVERLAY, // screen space, drawn over the world
+
+  RENDER_PASS_COUNT,
+} render_pass_t;
+
+typedef struct {
+  handle_t material;
+  handle_t mesh;
+  render_pass_t pass;
+  vec4 color; // tint, multiplied with the material color
+  transform_t transform;
+  transform_t previous; // as of the start of the last simulation step
+  mat3x4 model;
+  mat3x3 normal; // normal matrix of the model, see transform_batch_t
+  vec4 bounds;  // world space bounding sphere, xyz center and w radius
+  bool dirty;   // placed anew, model is rebuilt once with no blending
+  bool moving;  // moved by the last step, model is blended every frame
+  bool visible; // frustum culling result, overlay objects always pass
 } render_object_t; // single drawable object
 
 typedef struct {
   vec3 position;
-  f32 yaw;   // (x) in degrees
-  f32 pitch; // (y) in degrees
+  vec3 previous; // position as of the start of the last simulation step
+  quat orientation; // identity looks down -z with +y up
   f64 last_x;
   f64 last_y;
   bool first_mouse;
 
+  vec3 front, right, up; // cached from orientation
+  bool dirty; // view_proj is rebuilt on the next render_update
   mat4x4 view_proj;
 } camera_t;
 
 typedef struct {
-  material_t* material;
-  mesh_t* mesh;
+  handle_t material;
   f32 width, height, cell_width, cell_height;
 } sprite_sheet_t; // 2d ui element sheet
 
-GLFWwindow* render_init(u32 width, u32 height);
+typedef struct {
+  handle_t cube, ramp, light, sphere, quad;
+} render_scene_t; // the built in objects, drawn by render_cube() etc.
+
+typedef struct {
+  u32 uniform_lookups;       // glGetUniformLocation calls this frame
+  u32 uniform_lookups_total; // includes the ones done at link time
+  u32 draw_calls;
+  u32 instanced_draw_calls; // subset of draw_calls
+  u32 instances;            // objects drawn through instanced draw calls
+  u32 sprites;
+  u32 visible; // submitted objects that passed frustum culling
+  u32 culled;  // submitted objects that were skipped
+} render_stats_t;
+
+// offscreen draws into a framebuffer object with no window, returning NULL
+GLFWwindow* render_init(u32 width, u32 height, bool offscreen);
 void render_destroy(GLFWwindow* window);
 
 vec3* get_light_pos(void);
 camera_t* get_camera(void);
-void get_camera_front(vec3 result);
+const render_scene_t* get_scene(void);
+render_stats_t* get_render_stats(void);
+// measured on the render thread, RENDER_PACKET_COUNT frames ago
+const pass_timings_t* get_pass_timings(void);
+// gl calls issued and skipped by the state cache, from the same frame
+const gl_state_stats_t* get_gl_stats(void);
+// in screen coordinates, kept current by the resize callback
+iv2 get_window_size(void);
+void set_camera(vec3 const position, f32 yaw, f32 pitch); // degrees
+
+// pointers returned by these are only valid until the next create or destroy
+render_object_t* get_render_object(handle_t object);
+material_t* get_material(handle_t material);
+texture_t* get_texture(handle_t texture);
 
+handle_t render_object_create(handle_t mesh, handle_t material);
+void render_object_destroy(handle_t object);
+
+// starts a fixed simulation step at time seconds and runs the built in
+// animation. anything else that moves objects or the camera during the step
+// does so after this, setting moving on the objects it changes
+void render_step(f64 time);
+// once per frame, alpha blends between the last two simulation steps
+void render_update(f32 alpha);
+// records the frame into a packet the render thread draws after render_end.
+// render_begin blocks while every packet is still in flight
 void render_begin(void);
 void render_end(void);
+// headless only, writes the frame being recorded to path once it is drawn
+void render_dump(const char* path);
+
+// objects must not be created or destroyed between a submit and the flush
+void render_submit(handle_t object);
+void render_flush(void);
 
 void render_cube(void);
 void render_ramp(void);
 void render_light(void);
 void render_sphere(void);
 void render_quad(void);
+void sprite_sheet_tex_coords(vec4 result, const sprite_sheet_t* sheet,
+                             f32 row, f32 column);
 void render_sprite_frame(f32 row, f32 column, vec2 position, vec2 size,
                          vec4 color, bool is_flipped);
@@ -0,0 +1,94 @@
+#include "render_queue.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+// depth is expected in [0, 1], 0 being the closest to the camera
+static u32 quantize_depth(f32 depth) {
+  return (u32)(clamp(depth, 0.0f, 1.0f) * (f32)RENDER_KEY_DEPTH_MAX);
+}
+
+u64 render_key(render_pass_t pass, bool translucent, u32 program,
+               u32 material, u32 texture, u32 mesh, f32 depth) {
+  u64 key = ((u64)pass & 0x3) << 62;
+  u64 state = ((u64)(program & 0x1F) << 24) | ((u64)(material & 0xFF) << 16) |
+              ((u64)(texture & 0xFF) << 8) | (u64)(mesh & 0xFF);
+  u64 z = quantize_depth(depth);
+
+  if (translucent) {
+    // blended draws must be composited farthest first, state comes second
+    key |= 1ull << 61;
+    key |= (RENDER_KEY_DEPTH_MAX - z) << 37;
+    key |= state << 8;
+  } else {
+    key |= state << 32;
+    key |= z << 8;
+  }
+  return key;
+}
+
+void render_queue_init(render_queue_t* queue) {
+  queue->items = dynlist_create(render_item_t, 64);
+  queue->scratch = dynlist_create(render_item_t, 64);
+}
+
+void render_queue_destroy(render_queue_t* queue) {
+  dynlist_destroy(queue->items);
+  dynlist_destroy(queue->scratch);
+}
+
+void render_queue_push(render_queue_t* queue, u64 key,
+                       render_object_t* object) {
+  *dynlist_push(queue->items) = (render_item_t){.key = key, .object = object};
+}
+
+// lsd radix sort, stable so equal keys keep their submission order
+void render_queue_sort(render_queue_t* queue) {
+  size_t n = dynlist_size(queue->items);
+  if (n < 2) return;
+  dynlist_resize_no_contract(queue->scratch, n);
+
+  render_item_t* src = queue->items;
+  render_item_t* dst = queue->scratch;
+
+  // the spare and rarely used bits are usually identical across all keys,
+  // those digits are skipped entirely
+  u64 all_and = ~0ull, all_or = 0;
+  for (size_t i = 0; i < n; ++i) {
+    all_and &= src[i].key;
+    all_or |= src[i].key;
+  }
+  const u64 varying = all_and ^ all_or;
+
+  for (u32 pass = 0; pass < RADIX_PASSES; ++pass) {
+    const u32 shift = pass * RADIX_BITS;
+    if (((varying >> shift) & (RADIX_BUCKETS - 1)) == 0) continue;
+
+    size_t offsets[RADIX_BUCKETS] = {0};
+    for (size_t i = 0; i < n; ++i) {
+      ++offsets[(src[i].key >> shift) & (RADIX_BUCKETS - 1)];
+    }
+    size_t sum = 0;
+    for (u32 b = 0; b < RADIX_BUCKETS; ++b) {
+      size_t count = offsets[b];
+      offsets[b] = sum;
+      sum += count;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      dst[offsets[(src[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+    }
+
+    render_item_t* tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != queue->items) {
+    memcpy(queue->items, src, n * sizeof(render_item_t));
+  }
+}
+
+void render_queue_clear(render_queue_t* queue) {
+  dynlist_resize_no_contract(queue->items, 0);
+}
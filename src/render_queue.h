@@ -0,0 +1,39 @@
+#pragma once
+
+#include "c-lib/dynlist.h"
+#include "render.h"
+
+/*
+   draw key layout, most significant bits first, so a plain integer sort
+   groups draws by pass, then by the state that is most expensive to switch:
+
+   63..62 pass | 61 translucent | opaque:      60..56 program | 55..48 material
+                                               47..40 texture | 39..32 mesh
+                                               31..8  depth (front to back)
+                                | translucent: 60..37 depth (back to front)
+                                               36..32 program | 31..24 material
+                                               23..16 texture | 15..8  mesh
+   7..0 unused
+*/
+#define RENDER_KEY_DEPTH_BITS 24
+#define RENDER_KEY_DEPTH_MAX ((1u << RENDER_KEY_DEPTH_BITS) - 1)
+
+typedef struct {
+  u64 key;
+  render_object_t* object;
+} render_item_t;
+
+typedef struct {
+  DYNLIST(render_item_t) items;
+  DYNLIST(render_item_t) scratch; // ping-pong buffer for the radix sort
+} render_queue_t;
+
+u64 render_key(render_pass_t pass, bool translucent, u32 program,
+               u32 material, u32 texture, u32 mesh, f32 depth);
+
+void render_queue_init(render_queue_t* queue);
+void render_queue_destroy(render_queue_t* queue);
+void render_queue_push(render_queue_t* queue, u64 key,
+                       render_object_t* object);
+void render_queue_sort(render_queue_t* queue);
+void render_queue_clear(render_queue_t* queue);
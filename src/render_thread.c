@@ -0,0 +1,104 @@
+#include "render_thread.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "c-lib/misc.h"
+#include "c-lib/profile.h"
+
+static struct {
+  render_thread_desc_t desc;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t submitted_cond, retired_cond;
+  // frames ever submitted and executed, frame n is recorded in slot
+  // n % RENDER_PACKET_COUNT
+  u64 submitted, retired;
+  bool acquired; // the main thread is recording the next slot
+  bool quit;
+} rt;
+
+static void* render_thread_main(void* arg) {
+  (void)arg;
+  PROFILE_THREAD_NAME("render");
+  rt.desc.bind_context(true);
+
+  pthread_mutex_lock(&rt.lock);
+  for (;;) {
+    while (rt.retired == rt.submitted && !rt.quit) {
+      pthread_cond_wait(&rt.submitted_cond, &rt.lock);
+    }
+    if (rt.retired == rt.submitted) break; // quit, with nothing left to do
+
+    const u32 slot = rt.retired % RENDER_PACKET_COUNT;
+    pthread_mutex_unlock(&rt.lock);
+    rt.desc.execute(slot);
+    pthread_mutex_lock(&rt.lock);
+
+    ++rt.retired;
+    pthread_cond_broadcast(&rt.retired_cond);
+  }
+  pthread_mutex_unlock(&rt.lock);
+
+  rt.desc.bind_context(false);
+  return NULL;
+}
+
+void render_thread_start(const render_thread_desc_t* desc) {
+  memset(&rt, 0, sizeof(rt));
+  rt.desc = *desc;
+  pthread_mutex_init(&rt.lock, NULL);
+  pthread_cond_init(&rt.submitted_cond, NULL);
+  pthread_cond_init(&rt.retired_cond, NULL);
+
+  rt.desc.bind_context(false);
+  if (pthread_create(&rt.thread, NULL, render_thread_main, NULL) != 0) {
+    ERROR_EXIT("failed to create the render thread\n");
+  }
+}
+
+void render_thread_stop(void) {
+  ASSERT(!rt.acquired, "render thread stopped while recording a packet");
+  pthread_mutex_lock(&rt.lock);
+  rt.quit = true;
+  pthread_cond_signal(&rt.submitted_cond);
+  pthread_mutex_unlock(&rt.lock);
+  pthread_join(rt.thread, NULL);
+
+  pthread_cond_destroy(&rt.retired_cond);
+  pthread_cond_destroy(&rt.submitted_cond);
+  pthread_mutex_destroy(&rt.lock);
+  rt.desc.bind_context(true);
+}
+
+u32 render_thread_acquire(void) {
+  PROFILE_FUNC();
+  ASSERT(!rt.acquired, "a packet is already being recorded");
+  pthread_mutex_lock(&rt.lock);
+  while (rt.submitted - rt.retired >= RENDER_PACKET_COUNT) {
+    pthread_cond_wait(&rt.retired_cond, &rt.lock);
+  }
+  const u32 slot = rt.submitted % RENDER_PACKET_COUNT;
+  pthread_mutex_unlock(&rt.lock);
+  rt.acquired = true;
+  return slot;
+}
+
+void render_thread_submit(u32 slot) {
+  ASSERT(rt.acquired && slot == rt.submitted % RENDER_PACKET_COUNT,
+         "submitted slot %u was not acquired", slot);
+  rt.acquired = false;
+  pthread_mutex_lock(&rt.lock);
+  ++rt.submitted;
+  pthread_cond_signal(&rt.submitted_cond);
+  pthread_mutex_unlock(&rt.lock);
+}
+
+void render_thread_wait_idle(void) {
+  PROFILE_FUNC();
+  pthread_mutex_lock(&rt.lock);
+  while (rt.retired != rt.submitted) {
+    pthread_cond_wait(&rt.retired_cond, &rt.lock);
+  }
+  pthread_mutex_unlock(&rt.lock);
+}
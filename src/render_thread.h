@@ -0,0 +1,28 @@
+#pragma once
+
+#include "c-lib/types.h"
+
+// the gl context lives on a render thread that executes packets recorded by
+// the main thread. packets are recorded into a ring of slots: while the
+// render thread executes frame N the main thread records N + 1, and waits
+// before recording N + 2 until N is done. so submission overlaps the next
+// frame's simulation, and input reaches the screen at most one frame later
+// than when everything ran on one thread
+#define RENDER_PACKET_COUNT 2 // 3 allows one more frame in flight
+
+typedef struct {
+  void (*bind_context)(bool current); // on the calling thread
+  void (*execute)(u32 slot);          // on the render thread
+} render_thread_desc_t;
+
+// the calling thread gives up the context, which the render thread takes
+void render_thread_start(const render_thread_desc_t* desc);
+// waits for every submitted packet, the calling thread takes the context back
+void render_thread_stop(void);
+
+// blocks until the next slot is no longer being executed, then returns it
+u32 render_thread_acquire(void);
+// hands the acquired slot to the render thread
+void render_thread_submit(u32 slot);
+// blocks until every submitted packet has been executed
+void render_thread_wait_idle(void);
@@ -2,12 +2,21 @@
 layout (location = 0) in vec3 a_pos;
 layout (location = 1) in vec2 a_tex_coords;
 
+out vec4 v_color;
 out vec2 v_tex_coords;
 
 uniform mat4 u_model; // world transform
-uniform mat4 u_view_proj; // viewport transform
+uniform vec4 u_object_color;
+
+#ifdef MATH_ROW_MAJOR
+layout (row_major) uniform; // blocks match the cpu side matrices
+#endif
+layout (std140) uniform camera_block {
+  mat4 u_view_proj; // viewport transform
+};
 
 void main() {
   gl_Position = u_view_proj * u_model * vec4(a_pos, 1.0);
   v_tex_coords = a_tex_coords;
+  v_color = u_object_color;
 }
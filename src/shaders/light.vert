@@ -7,17 +7,27 @@ smooth out vec4 v_color;
 out vec2 v_tex_coords;
 
 uniform mat4 u_model; // world transform
-uniform mat4 u_view_proj; // viewport transform
+uniform mat3 u_normal_matrix; // inverse transpose of the model, unnormalized
+uniform vec4 u_object_color;
 
-uniform vec3 u_light_pos;
-uniform vec4 u_light_color; // incorporates light intensity
-uniform vec4 u_ambient_intensity;
+#ifdef MATH_ROW_MAJOR
+layout (row_major) uniform; // blocks match the cpu side matrices
+#endif
+layout (std140) uniform camera_block {
+  mat4 u_view_proj; // viewport transform
+};
+
+layout (std140) uniform light_block {
+  vec4 u_light_pos; // normalized, w unused
+  vec4 u_light_color; // incorporates light intensity
+  vec4 u_ambient_intensity;
+};
 
 void main() {
   gl_Position = u_view_proj * u_model * vec4(a_pos, 1.0);
   v_tex_coords = a_tex_coords;
 
-  vec3 norm = mat3(u_model) * a_normal; // rotation component applied to normal
-  float diffuse = max(dot(norm, u_light_pos), 0.0);
-  v_color = (u_ambient_intensity + diffuse) * u_light_color;
+  vec3 norm = normalize(a_normal * u_normal_matrix); // rows read as columns
+  float diffuse = max(dot(norm, u_light_pos.xyz), 0.0);
+  v_color = (u_ambient_intensity + diffuse) * u_light_color * u_object_color;
 }
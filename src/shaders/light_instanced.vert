@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) in vec3 a_pos;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_tex_coords;
+layout (location = 3) in mat4 a_model; // per instance world transform
+layout (location = 7) in vec4 a_color; // per instance color
+layout (location = 8) in mat3 a_normal_matrix; // per instance, unnormalized
+
+smooth out vec4 v_color;
+out vec2 v_tex_coords;
+
+#ifdef MATH_ROW_MAJOR
+layout (row_major) uniform; // blocks match the cpu side matrices
+#endif
+layout (std140) uniform camera_block {
+  mat4 u_view_proj; // viewport transform
+};
+
+layout (std140) uniform light_block {
+  vec4 u_light_pos; // normalized, w unused
+  vec4 u_light_color; // incorporates light intensity
+  vec4 u_ambient_intensity;
+};
+
+void main() {
+#ifdef MATH_ROW_MAJOR
+  // the rows of the row major model are read in as columns, so vectors are
+  // multiplied from the left to get the same transform as u_model * pos
+  gl_Position = u_view_proj * (vec4(a_pos, 1.0) * a_model);
+#else
+  gl_Position = u_view_proj * a_model * vec4(a_pos, 1.0);
+#endif
+  v_tex_coords = a_tex_coords;
+
+  vec3 norm = normalize(a_normal * a_normal_matrix); // rows read as columns
+  float diffuse = max(dot(norm, u_light_pos.xyz), 0.0);
+  v_color = (u_ambient_intensity + diffuse) * u_light_color * a_color;
+}
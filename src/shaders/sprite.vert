@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec2 a_pos; // already in screen space
+layout (location = 1) in vec2 a_tex_coords;
+layout (location = 2) in vec4 a_color;
+
+out vec4 v_color;
+out vec2 v_tex_coords;
+
+#ifdef MATH_ROW_MAJOR
+layout (row_major) uniform; // blocks match the cpu side matrices
+#endif
+layout (std140) uniform camera_block {
+  mat4 u_view_proj; // viewport transform
+};
+
+void main() {
+  gl_Position = u_view_proj * vec4(a_pos, 0.0, 1.0);
+  v_tex_coords = a_tex_coords;
+  v_color = a_color;
+}
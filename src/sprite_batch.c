@@ -0,0 +1,185 @@
+#include "sprite_batch.h"
+
+#include <glad/glad.h>
+#include <stddef.h>
+
+#include "c-lib/dynlist.h"
+#include "gl_state.h"
+
+typedef struct {
+  const shader_t* shader;
+  u32 vao, vbo, ebo;
+  size_t vbo_capacity, vbo_cursor; // bytes
+
+  sprite_list_t* recording; // where pushes go, on the recording thread
+} sprite_batch_t;
+
+static sprite_batch_t batch;
+
+static void create_quad_indices(void) {
+  // every sprite is the same two triangles, so one index buffer covers any
+  // range of sprites when drawn with a base vertex
+  u32 count = SPRITE_BATCH_MAX_DRAW * 6;
+  u32* indices = (u32*)malloc(count * sizeof(u32));
+  ASSERT(indices);
+  for (u32 i = 0, v = 0; i < count; i += 6, v += 4) {
+    indices[i + 0] = v + 0;
+    indices[i + 1] = v + 1;
+    indices[i + 2] = v + 3;
+    indices[i + 3] = v + 1;
+    indices[i + 4] = v + 2;
+    indices[i + 5] = v + 3;
+  }
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, batch.ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(u32), indices,
+               GL_STATIC_DRAW);
+  free(indices);
+}
+
+void sprite_list_init(sprite_list_t* list) {
+  list->vertices = dynlist_create(sprite_vertex_t, 1024);
+  list->runs = dynlist_create(sprite_run_t, 16);
+}
+
+void sprite_list_destroy(sprite_list_t* list) {
+  dynlist_destroy(list->vertices);
+  dynlist_destroy(list->runs);
+}
+
+void sprite_list_clear(sprite_list_t* list) {
+  dynlist_resize_no_contract(list->vertices, 0);
+  dynlist_resize_no_contract(list->runs, 0);
+}
+
+u32 sprite_list_count(const sprite_list_t* list) {
+  return dynlist_size(list->vertices) / 4;
+}
+
+u32 sprite_list_draw_calls(const sprite_list_t* list) {
+  u32 draw_calls = 0;
+  for (u32 i = 0; i < dynlist_size(list->runs); ++i) {
+    draw_calls += (list->runs[i].count + SPRITE_BATCH_MAX_DRAW - 1) /
+                  SPRITE_BATCH_MAX_DRAW;
+  }
+  return draw_calls;
+}
+
+void sprite_batch_init(const shader_t* shader) {
+  batch.shader = shader;
+  batch.vbo_capacity = SPRITE_BATCH_MAX_DRAW * 4 * sizeof(sprite_vertex_t);
+  batch.vbo_cursor = 0;
+  batch.recording = NULL;
+
+  glGenVertexArrays(1, &batch.vao);
+  glGenBuffers(1, &batch.vbo);
+  glGenBuffers(1, &batch.ebo);
+
+  gl_state_bind_vertex_array(batch.vao);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, batch.vbo);
+  glBufferData(GL_ARRAY_BUFFER, batch.vbo_capacity, NULL, GL_STREAM_DRAW);
+  create_quad_indices();
+
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex_t),
+                        (void*)offsetof(sprite_vertex_t, position));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(sprite_vertex_t),
+                        (void*)offsetof(sprite_vertex_t, tex_coords));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                        sizeof(sprite_vertex_t),
+                        (void*)offsetof(sprite_vertex_t, color));
+  glEnableVertexAttribArray(2);
+
+  gl_state_bind_vertex_array(0);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, 0);
+  gl_state_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void sprite_batch_destroy(void) {
+  gl_state_delete_vertex_array(batch.vao);
+  gl_state_delete_buffer(batch.vbo);
+  gl_state_delete_buffer(batch.ebo);
+}
+
+void sprite_batch_record(sprite_list_t* list) { batch.recording = list; }
+
+void sprite_batch_push(u32 texture, u32 sampler, vec2 const position,
+                       vec2 const size, vec4 const uv, vec4 const color) {
+  sprite_list_t* list = batch.recording;
+  if (!list) return;
+
+  // consecutive sprites sharing a texture become one draw call
+  size_t run_count = dynlist_size(list->runs);
+  sprite_run_t* run = run_count ? &list->runs[run_count - 1] : NULL;
+  if (!run || run->texture != texture || run->sampler != sampler) {
+    run = dynlist_push(list->runs);
+    *run = (sprite_run_t){
+        .texture = texture,
+        .sampler = sampler,
+        .first = dynlist_size(list->vertices) / 4,
+    };
+  }
+  ++run->count;
+
+  f32 x0 = position[0] - size[0] * 0.5f, x1 = position[0] + size[0] * 0.5f;
+  f32 y0 = position[1] - size[1] * 0.5f, y1 = position[1] + size[1] * 0.5f;
+  u8 r = (u8)(clamp(color[0], 0.0f, 1.0f) * 255.0f);
+  u8 g = (u8)(clamp(color[1], 0.0f, 1.0f) * 255.0f);
+  u8 b = (u8)(clamp(color[2], 0.0f, 1.0f) * 255.0f);
+  u8 a = (u8)(clamp(color[3], 0.0f, 1.0f) * 255.0f);
+
+  size_t n = dynlist_size(list->vertices);
+  dynlist_resize_no_contract(list->vertices, n + 4);
+  sprite_vertex_t* v = &list->vertices[n];
+  v[0] = (sprite_vertex_t){{x1, y1}, {uv[2], uv[3]}, {r, g, b, a}}; // top r
+  v[1] = (sprite_vertex_t){{x1, y0}, {uv[2], uv[1]}, {r, g, b, a}}; // bot r
+  v[2] = (sprite_vertex_t){{x0, y0}, {uv[0], uv[1]}, {r, g, b, a}}; // bot l
+  v[3] = (sprite_vertex_t){{x0, y1}, {uv[0], uv[3]}, {r, g, b, a}}; // top l
+}
+
+// appends to a ring buffer without synchronizing, the buffer is only orphaned
+// when it wraps, so the gpu never waits on a region still being drawn from
+static size_t upload_vertices(const sprite_list_t* list) {
+  size_t size = dynlist_size(list->vertices) * sizeof(sprite_vertex_t);
+  gl_state_bind_buffer(GL_ARRAY_BUFFER, batch.vbo);
+
+  GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                      GL_MAP_INVALIDATE_RANGE_BIT;
+  if (batch.vbo_cursor + size > batch.vbo_capacity) {
+    while (batch.vbo_capacity < size * 2) batch.vbo_capacity *= 2;
+    glBufferData(GL_ARRAY_BUFFER, batch.vbo_capacity, NULL, GL_STREAM_DRAW);
+    batch.vbo_cursor = 0;
+  }
+
+  size_t offset = batch.vbo_cursor;
+  void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, access);
+  ASSERT(dst, "failed to map the sprite vertex buffer");
+  memcpy(dst, list->vertices, size);
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+
+  batch.vbo_cursor += size;
+  return offset;
+}
+
+// expects the screen camera to be bound
+u32 sprite_batch_flush(const sprite_list_t* list) {
+  if (dynlist_size(list->vertices) == 0) return 0;
+
+  gl_state_bind_vertex_array(batch.vao);
+  gl_state_use_program(batch.shader->program);
+  u32 base_vertex = upload_vertices(list) / sizeof(sprite_vertex_t);
+
+  u32 draw_calls = 0;
+  for (u32 i = 0; i < dynlist_size(list->runs); ++i) {
+    const sprite_run_t* run = &list->runs[i];
+    gl_state_bind_texture(0, run->texture);
+    gl_state_bind_sampler(0, run->sampler);
+    for (u32 done = 0; done < run->count; done += SPRITE_BATCH_MAX_DRAW) {
+      u32 count = min(run->count - done, SPRITE_BATCH_MAX_DRAW);
+      glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_INT, NULL,
+                               base_vertex + (run->first + done) * 4);
+      ++draw_calls;
+    }
+  }
+  return draw_calls;
+}
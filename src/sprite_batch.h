@@ -0,0 +1,41 @@
+#pragma once
+
+#include "c-lib/dynlist.h"
+#include "c-lib/math.h"
+#include "render.h"
+
+#define SPRITE_BATCH_MAX_DRAW 16384 // sprites per draw call
+
+typedef struct {
+  vec2 position;
+  vec2 tex_coords;
+  u8 color[4]; // normalized in the shader
+} sprite_vertex_t;
+
+typedef struct {
+  u32 texture, sampler;
+  u32 first, count; // in sprites
+} sprite_run_t;
+
+// the sprites of one frame, recorded on the cpu and drawn in a single flush
+typedef struct {
+  DYNLIST(sprite_vertex_t) vertices;
+  DYNLIST(sprite_run_t) runs;
+} sprite_list_t;
+
+void sprite_list_init(sprite_list_t* list);
+void sprite_list_destroy(sprite_list_t* list);
+void sprite_list_clear(sprite_list_t* list);
+u32 sprite_list_count(const sprite_list_t* list);
+u32 sprite_list_draw_calls(const sprite_list_t* list);
+
+void sprite_batch_init(const shader_t* shader);
+void sprite_batch_destroy(void);
+
+// pushes go into list until the next call, NULL drops them
+void sprite_batch_record(sprite_list_t* list);
+// uv is {u_min, v_min, u_max, v_max}, position is the center of the sprite
+void sprite_batch_push(u32 texture, u32 sampler, vec2 const position,
+                       vec2 const size, vec4 const uv, vec4 const color);
+// needs the gl context, returns the number of draw calls
+u32 sprite_batch_flush(const sprite_list_t* list);
@@ -1,41 +1,163 @@
+#include <errno.h>
 #include <math.h>
 #include <time.h>
 
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
-
-#include "c-lib/log.h"
+#include "c-lib/misc.h"
+#include "c-lib/profile.h"
+#include "c-lib/time.h"
 #include "state.h"
 #include "time_state.h"
 
-void time_init(f32 frame_rate) {
-  state.time.frame_rate = frame_rate;
-  state.time.frame_delay = 1000.f / frame_rate;    // ms per frame
-  state.time.last = (f32)(glfwGetTime() * 1000.0); // convert to ms
-  LOG("Time system initialized");
+// the kernel wakes a sleeper late by up to a scheduler tick, so the sleep
+// ends this far before the deadline and the rest is spun
+#define PACER_SPIN_NS 1000000ull
+
+// absolute, clock_nanosleep deadlines are on the same clock
+static u64 monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static void histogram_add(time_histogram_t* histogram, u64 ns) {
+  u64 bin = ns / TIME_HISTOGRAM_BIN_NS;
+  ++histogram->bins[bin < TIME_HISTOGRAM_BINS ? bin : TIME_HISTOGRAM_BINS - 1];
+  ++histogram->count;
+  if (ns > histogram->max_ns) histogram->max_ns = ns;
+}
+
+f64 time_histogram_percentile(const time_histogram_t* histogram, f64 p) {
+  if (histogram->count == 0) return 0.0;
+  const u32 rank = (u32)ceil(p / 100.0 * histogram->count);
+  u32 seen = 0;
+  for (u32 i = 0; i < TIME_HISTOGRAM_BINS; ++i) {
+    seen += histogram->bins[i];
+    if (seen >= rank) {
+      return (i + 1) * (TIME_HISTOGRAM_BIN_NS / 1000.0);
+    }
+  }
+  return TIME_HISTOGRAM_BINS * (TIME_HISTOGRAM_BIN_NS / 1000.0);
+}
+
+void time_reset_pacing_stats(void) {
+  time_pacer_t* pacer = &state.time.pacer;
+  pacer->missed = 0;
+  pacer->overshoot = (time_histogram_t){0};
+  pacer->jitter = (time_histogram_t){0};
+}
+
+void time_init(u32 target_rate, u32 sim_rate) {
+  ASSERT(sim_rate > 0, "the simulation rate can't be 0");
+  state.time.last_ns = state.time.frame_last_ns = time_ns();
+  state.time.sim_step_ns = 1000000000ull / sim_rate;
+  state.time.sim_step = (f32)(state.time.sim_step_ns / 1000000.0);
+  state.time.pacer = (time_pacer_t){
+      .target_rate = target_rate,
+      .period_ns = target_rate ? 1000000000ull / target_rate : 0,
+  };
+  if (target_rate) {
+    LOG("Time system initialized, paced at %u fps, simulated at %u hz",
+        target_rate, sim_rate);
+  } else {
+    LOG("Time system initialized, unpaced, simulated at %u hz", sim_rate);
+  }
+}
+
+// simulated time for reproducible runs, frames are still paced if a target
+// rate was set so pacing itself can be measured
+void time_set_fixed_step(u64 step_ns) {
+  state.time.fixed_step_ns = step_ns;
+  state.time.now_ns = state.time.last_ns = state.time.frame_last_ns = 0;
+  state.time.sim_accumulator_ns = state.time.sim_steps = 0;
+  state.time.sim_time = 0.0;
 }
 
 void time_update(void) {
-  state.time.now = (f32)(glfwGetTime() * 1000.0);                  // ms
-  state.time.delta = (state.time.now - state.time.last) / 1000.0f; // s
-  state.time.last = state.time.now;
+  PROFILE_FUNC();
+  if (state.time.fixed_step_ns) {
+    state.time.now_ns = state.time.last_ns + state.time.fixed_step_ns;
+  } else {
+    state.time.now_ns = time_ns();
+  }
+  const u64 elapsed_ns = state.time.now_ns - state.time.last_ns;
+  state.time.delta = (f32)ns_to_sec(elapsed_ns);
+  state.time.last_ns = state.time.now_ns;
   ++state.time.frame_count;
 
-  if (state.time.now - state.time.frame_last >= 1000.0f) {
+  // integer ns, so a fixed clock steps the same every run
+  const u64 max_accumulated = TIME_MAX_SIM_STEPS * state.time.sim_step_ns;
+  state.time.sim_accumulator_ns += elapsed_ns;
+  if (state.time.sim_accumulator_ns > max_accumulated) {
+    state.time.sim_accumulator_ns = max_accumulated;
+  }
+
+  if (state.time.now_ns - state.time.frame_last_ns >= 1000000000ull) {
     state.time.frame_rate = state.time.frame_count;
     state.time.frame_count = 0;
-    state.time.frame_last = state.time.now;
+    state.time.frame_last_ns = state.time.now_ns;
   }
 }
 
+bool time_sim_step(void) {
+  if (state.time.sim_accumulator_ns >= state.time.sim_step_ns) {
+    state.time.sim_accumulator_ns -= state.time.sim_step_ns;
+    ++state.time.sim_steps;
+    // from the step count, so sim_time never drifts from a running sum
+    state.time.sim_time =
+        ns_to_sec((f64)state.time.sim_steps * state.time.sim_step_ns);
+    return true;
+  }
+  state.time.alpha = (f32)((f64)state.time.sim_accumulator_ns /
+                           state.time.sim_step_ns);
+  return false;
+}
+
+// sleeps to just short of the deadline, then spins the remainder
+static u64 wait_until(u64 deadline) {
+  if (deadline > PACER_SPIN_NS) {
+    const u64 wake = deadline - PACER_SPIN_NS;
+    const struct timespec ts = {
+        .tv_sec = (time_t)(wake / 1000000000ull),
+        .tv_nsec = (long)(wake % 1000000000ull),
+    };
+    // an absolute deadline, so a signal can simply restart the same sleep
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+           EINTR) {
+    }
+  }
+
+  u64 now = monotonic_ns();
+  while (now < deadline) now = monotonic_ns();
+  return now;
+}
+
 void time_update_late(void) {
-  state.time.frame_time = (f32)(glfwGetTime() * 1000.0) - state.time.now;
+  PROFILE_FUNC();
+  time_pacer_t* pacer = &state.time.pacer;
+  u64 now = monotonic_ns();
+  if (!state.time.fixed_step_ns) {
+    state.time.frame_time = (f32)((time_ns() - state.time.now_ns) / 1000000.0);
+  }
+  if (pacer->period_ns == 0) return;
+
+  // deadlines advance by exactly one period, so sleep error never accumulates
+  if (pacer->deadline_ns == 0) {
+    pacer->deadline_ns = now;
+  } else if (now >= pacer->deadline_ns) {
+    // late, start a new chain here instead of rushing frames to catch up
+    ++pacer->missed;
+    pacer->deadline_ns = now;
+  } else {
+    now = wait_until(pacer->deadline_ns);
+    histogram_add(&pacer->overshoot, now - pacer->deadline_ns);
+  }
 
-  if (state.time.frame_delay > state.time.frame_time) {
-    f32 delay_ms = state.time.frame_delay - state.time.frame_time;
-    struct timespec ts;
-    ts.tv_sec = (time_t)(delay_ms / 1000.0f);
-    ts.tv_nsec = (long)((fmod(delay_ms, 1000.0f)) * 1e6);
-    nanosleep(&ts, NULL);
+  if (pacer->last_wake_ns) {
+    const u64 length = now - pacer->last_wake_ns;
+    histogram_add(&pacer->jitter, length > pacer->period_ns
+                                      ? length - pacer->period_ns
+                                      : pacer->period_ns - length);
   }
+  pacer->last_wake_ns = now;
+  pacer->deadline_ns += pacer->period_ns;
 }
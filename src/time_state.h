@@ -2,12 +2,60 @@
 
 #include "c-lib/types.h"
 
+#define TIME_HISTOGRAM_BINS 64
+#define TIME_HISTOGRAM_BIN_NS 25000 // 25us per bin, the last bin is overflow
+#define TIME_MAX_SIM_STEPS 8 // per frame, a longer stall drops simulated time
+
+typedef struct {
+  u32 bins[TIME_HISTOGRAM_BINS];
+  u32 count;
+  u64 max_ns;
+} time_histogram_t;
+
 typedef struct {
-  f32 delta, now, last;
-  f32 frame_last, frame_delay, frame_time;
-  u32 frame_rate, frame_count;
+  u32 target_rate;  // fps, 0 leaves pacing to vsync
+  u64 period_ns;    // target frame length, 0 without a target rate
+  u64 deadline_ns;  // absolute CLOCK_MONOTONIC time the next frame starts
+  u64 last_wake_ns;
+  u32 missed;                 // frames that ran past their deadline
+  time_histogram_t overshoot; // woken after the deadline by
+  time_histogram_t jitter;    // distance of each frame length from period
+} time_pacer_t;
+
+typedef struct {
+  // time_ns() stamps, f32 ms would lose precision as a run goes on
+  u64 now_ns, last_ns;
+  u64 frame_last_ns; // start of the second frame_rate is counted over
+  f32 delta;         // s since the last frame
+  f32 frame_time;    // ms spent on the last frame, before pacing
+  u32 frame_rate, frame_count; // measured over each second
+  u64 fixed_step_ns; // added per frame instead of reading the clock, or 0
+  time_pacer_t pacer;
+
+  // the simulation advances in steps of sim_step_ns, independent of the
+  // frame rate, and rendering blends the last two steps by alpha. the
+  // bookkeeping is in whole ns so a run steps the same on any clock reading
+  u64 sim_step_ns;
+  u64 sim_accumulator_ns; // frame time not simulated yet
+  u64 sim_steps;          // taken since the clock started
+  f32 sim_step;           // ms, sim_step_ns for callers
+  f64 sim_time;           // s, sim_steps * sim_step_ns
+  f32 alpha;              // 0 draws the previous step, 1 the latest
 } time_state_t;
 
-void time_init(f32 frame_rate);
+// target_rate in frames per second, 0 for no pacing. sim_rate in steps per
+// second
+void time_init(u32 target_rate, u32 sim_rate);
+void time_set_fixed_step(u64 step_ns);
 void time_update(void);
+// true while a simulation step is due, advancing sim_time by one step. sets
+// alpha once it returns false
+//   while (time_sim_step()) simulate(state.time.sim_step);
+bool time_sim_step(void);
+// sleeps until the next frame deadline, called once the frame is done
 void time_update_late(void);
+
+// clears the histograms and missed count, keeps the deadline chain
+void time_reset_pacing_stats(void);
+// upper edge of the bin holding the p-th percentile, in us
+f64 time_histogram_percentile(const time_histogram_t* histogram, f64 p);
@@ -0,0 +1,159 @@
+#include "transform_batch.h"
+
+#if MATH_SIMD
+#define TRANSFORM_LANES 4
+#else
+#define TRANSFORM_LANES 1
+#endif
+
+void transform_batch_init(transform_batch_t* batch) {
+  *batch = (transform_batch_t){
+      .x = dynlist_create(f32, 1024),
+      .y = dynlist_create(f32, 1024),
+      .z = dynlist_create(f32, 1024),
+      .qx = dynlist_create(f32, 1024),
+      .qy = dynlist_create(f32, 1024),
+      .qz = dynlist_create(f32, 1024),
+      .qw = dynlist_create(f32, 1024),
+      .sx = dynlist_create(f32, 1024),
+      .sy = dynlist_create(f32, 1024),
+      .sz = dynlist_create(f32, 1024),
+      .model = dynlist_create(mat3x4, 1024),
+      .normal = dynlist_create(mat3x3, 1024),
+  };
+}
+
+void transform_batch_destroy(transform_batch_t* batch) {
+  dynlist_destroy(batch->x);
+  dynlist_destroy(batch->y);
+  dynlist_destroy(batch->z);
+  dynlist_destroy(batch->qx);
+  dynlist_destroy(batch->qy);
+  dynlist_destroy(batch->qz);
+  dynlist_destroy(batch->qw);
+  dynlist_destroy(batch->sx);
+  dynlist_destroy(batch->sy);
+  dynlist_destroy(batch->sz);
+  dynlist_destroy(batch->model);
+  dynlist_destroy(batch->normal);
+}
+
+void transform_batch_resize(transform_batch_t* batch, u32 n) {
+  dynlist_resize_no_contract(batch->x, n);
+  dynlist_resize_no_contract(batch->y, n);
+  dynlist_resize_no_contract(batch->z, n);
+  dynlist_resize_no_contract(batch->qx, n);
+  dynlist_resize_no_contract(batch->qy, n);
+  dynlist_resize_no_contract(batch->qz, n);
+  dynlist_resize_no_contract(batch->qw, n);
+  dynlist_resize_no_contract(batch->sx, n);
+  dynlist_resize_no_contract(batch->sy, n);
+  dynlist_resize_no_contract(batch->sz, n);
+  dynlist_resize_no_contract(batch->model, n);
+  dynlist_resize_no_contract(batch->normal, n);
+}
+
+// rotation, then the scale multiplies each column, and the position is the
+// last column. the same steps as quat_to_mat3x4 and mat3x4_scale_aniso, so
+// both paths round the same.
+//
+// the normal matrix of R S is R S^-1. it is kept as the cofactors instead,
+// R times the product of the other two scales, which is the same up to the
+// determinant and needs no divide, so a zero scale stays defined. the sign
+// of the determinant keeps normals pointing out of mirrored objects. it is
+// the sign bit, like the lanes take it, so a -0 scale counts as mirrored
+static void transform_one(const transform_batch_t* batch, u32 i,
+                          mat3x4 model, mat3x3 normal) {
+  const quat q = {batch->qx[i], batch->qy[i], batch->qz[i], batch->qw[i]};
+  const f32 kx = batch->sx[i], ky = batch->sy[i], kz = batch->sz[i];
+  const f32 sign = signbit(kx * ky * kz) ? -1.0f : 1.0f;
+  const vec3 cofactor = {ky * kz * sign, kx * kz * sign, kx * ky * sign};
+  quat_to_mat3x4(model, q);
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) normal[r][c] = model[r][c] * cofactor[c];
+  }
+  mat3x4_scale_aniso(model, kx, ky, kz);
+  model[0][3] = batch->x[i];
+  model[1][3] = batch->y[i];
+  model[2][3] = batch->z[i];
+}
+
+#if TRANSFORM_LANES == 4
+// one matrix element per lane and four objects at once, then transposed
+// into a row of each object's matrix
+static void transform_lanes(transform_batch_t* batch, u32 i) {
+  const __m128 x = _mm_loadu_ps(&batch->qx[i]);
+  const __m128 y = _mm_loadu_ps(&batch->qy[i]);
+  const __m128 z = _mm_loadu_ps(&batch->qz[i]);
+  const __m128 w = _mm_loadu_ps(&batch->qw[i]);
+  const __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y);
+  const __m128 z2 = _mm_add_ps(z, z);
+  const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2);
+  const __m128 zz = _mm_mul_ps(z, z2);
+  const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2);
+  const __m128 yz = _mm_mul_ps(y, z2);
+  const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2);
+  const __m128 wz = _mm_mul_ps(w, z2);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 rotation[3][3] = {
+      {_mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_sub_ps(xy, wz),
+       _mm_add_ps(xz, wy)},
+      {_mm_add_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)),
+       _mm_sub_ps(yz, wx)},
+      {_mm_sub_ps(xz, wy), _mm_add_ps(yz, wx),
+       _mm_sub_ps(one, _mm_add_ps(xx, yy))},
+  };
+
+  const __m128 kx = _mm_loadu_ps(&batch->sx[i]);
+  const __m128 ky = _mm_loadu_ps(&batch->sy[i]);
+  const __m128 kz = _mm_loadu_ps(&batch->sz[i]);
+  const __m128 scale[3] = {kx, ky, kz};
+  const __m128 sign =
+      _mm_and_ps(_mm_mul_ps(_mm_mul_ps(kx, ky), kz), _mm_set1_ps(-0.0f));
+  const __m128 cofactor[3] = {
+      _mm_xor_ps(_mm_mul_ps(ky, kz), sign),
+      _mm_xor_ps(_mm_mul_ps(kx, kz), sign),
+      _mm_xor_ps(_mm_mul_ps(kx, ky), sign),
+  };
+  const __m128 position[3] = {
+      _mm_loadu_ps(&batch->x[i]),
+      _mm_loadu_ps(&batch->y[i]),
+      _mm_loadu_ps(&batch->z[i]),
+  };
+
+  // the normal rows leave their fourth element unused
+  __m128 rows[3][4], normal_rows[3][4];
+  for (u32 r = 0; r < 3; ++r) {
+    for (u32 c = 0; c < 3; ++c) {
+      rows[r][c] = _mm_mul_ps(rotation[r][c], scale[c]);
+      normal_rows[r][c] = _mm_mul_ps(rotation[r][c], cofactor[c]);
+    }
+    rows[r][3] = position[r];
+    normal_rows[r][3] = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+    _MM_TRANSPOSE4_PS(normal_rows[r][0], normal_rows[r][1], normal_rows[r][2],
+                      normal_rows[r][3]);
+  }
+  for (u32 lane = 0; lane < 4; ++lane) {
+    vec4* model = batch->model[i + lane];
+    vec3* normal = batch->normal[i + lane];
+    for (u32 r = 0; r < 3; ++r) {
+      _mm_storeu_ps(model[r], rows[r][lane]);
+      math_store3(normal[r], normal_rows[r][lane]);
+    }
+  }
+}
+#endif
+
+void transform_batch_run(transform_batch_t* batch, u32 begin, u32 end) {
+  ASSERT(end <= dynlist_size(batch->x));
+  u32 i = begin;
+#if TRANSFORM_LANES == 4
+  for (; i + TRANSFORM_LANES <= end; i += TRANSFORM_LANES) {
+    transform_lanes(batch, i);
+  }
+#endif
+  for (; i < end; ++i) {
+    transform_one(batch, i, batch->model[i], batch->normal[i]);
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "c-lib/dynlist.h"
+#include "c-lib/math.h"
+#include "c-lib/types.h"
+
+// object transforms in SoA layout, turned into model matrices 4 at a time.
+// a model matrix is translate * rotate * scale
+typedef struct {
+  DYNLIST(f32) x; // position
+  DYNLIST(f32) y;
+  DYNLIST(f32) z;
+  DYNLIST(f32) qx; // unit quaternion
+  DYNLIST(f32) qy;
+  DYNLIST(f32) qz;
+  DYNLIST(f32) qw;
+  DYNLIST(f32) sx; // scale
+  DYNLIST(f32) sy;
+  DYNLIST(f32) sz;
+  DYNLIST(mat3x4) model;  // written by transform_batch_run
+  DYNLIST(mat3x3) normal; // (A^-1)^T of the model up to a positive scale
+} transform_batch_t;
+
+void transform_batch_init(transform_batch_t* batch);
+void transform_batch_destroy(transform_batch_t* batch);
+void transform_batch_resize(transform_batch_t* batch, u32 n);
+// builds the model and normal matrices in [begin, end). ranges that don't
+// overlap can run on separate threads
+void transform_batch_run(transform_batch_t* batch, u32 begin, u32 end);